@@ -92,9 +92,24 @@ void printUsage() {
     << "                          Valid values for OpenCL: 'off' and 'Array2D'\n"
     << "  -use-local <o>          Enable/disable usage of shared/local memory in CUDA/OpenCL to stage image pixels to scratchpad\n"
     << "                          Valid values: 'on' and 'off'\n"
-    << "  -vectorize <o>          Enable/disable vectorization of generated CUDA/OpenCL code\n"
+    << "  -vectorize <o>          Enable/disable vectorization of generated code\n"
     << "                          Valid values: 'on' and 'off'\n"
+    << "                          Valid values for C++ code to select the SIMD width: 'sse4.2', 'avx2' (default for 'on'), and 'avx512'\n"
+    << "                          The generated C++ code has to be compiled for that instruction set, e.g. using -mavx2\n"
     << "  -pixels-per-thread <n>  Specify how many pixels should be calculated per thread\n"
+    << "                          For C++ code: rows computed per iteration of the row loop\n"
+    << "  -cpu-threads <n>        Specify how many threads should execute C++ kernels, split into bands of rows\n"
+    << "                          Valid values: number of threads or 'auto' to use all hardware threads\n"
+    << "  -cpu-async <o>          Enable/disable asynchronous launches of C++ kernels, overlapping independent kernels\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -cpu-tile <o>           Specify the size of cache blocks the iteration space of C++ kernels is split into\n"
+    << "                          Valid values: 'auto', 'off' (default), or tile size <nxm>, e.g. 512x64; m=0 tiles only the width\n"
+    << "  -fuse <o>               Enable/disable fusion of point operators into the kernel consuming their output in C++ code\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -stream <o>             Enable/disable row-by-row execution of local operator chains through ring buffers in C++ code\n"
+    << "                          Valid values: 'on' and 'off'\n"
+    << "  -rotate <o>             Enable/disable rotation of local operator windows through registers along rows in C++ code\n"
+    << "                          Valid values: 'on' and 'off'\n"
     << "  -rs-package <string>    Specify Renderscript package name. (default: \"org.hipacc.rs\")\n"
     << "  -o <file>               Write output to <file>\n"
     << "  --help                  Display available options\n"
@@ -270,6 +285,15 @@ int main(int argc, char *argv[]) {
         compilerOptions.setVectorizeKernels(USER_OFF);
       } else if (StringRef(argv[i+1]) == "on") {
         compilerOptions.setVectorizeKernels(USER_ON);
+      } else if (StringRef(argv[i+1]) == "sse4.2") {
+        compilerOptions.setVectorizeKernels(USER_ON);
+        compilerOptions.setVectorWidth(16);
+      } else if (StringRef(argv[i+1]) == "avx2") {
+        compilerOptions.setVectorizeKernels(USER_ON);
+        compilerOptions.setVectorWidth(32);
+      } else if (StringRef(argv[i+1]) == "avx512") {
+        compilerOptions.setVectorizeKernels(USER_ON);
+        compilerOptions.setVectorWidth(64);
       } else {
         llvm::errs() << "ERROR: Expected valid vectorization specification for -use-vectorize switch.\n\n";
         printUsage();
@@ -292,6 +316,97 @@ int main(int argc, char *argv[]) {
       ++i;
       continue;
     }
+    if (StringRef(argv[i]) == "-cpu-threads") {
+      assert(i<(argc-1) && "Mandatory thread specification for -cpu-threads switch missing.");
+      int val = 0;
+      if (StringRef(argv[i+1]) != "auto") {
+        std::istringstream buffer(argv[i+1]);
+        buffer >> val;
+        if (buffer.fail() || val < 1) {
+          llvm::errs() << "ERROR: Expected positive integer or 'auto' for -cpu-threads switch.\n\n";
+          printUsage();
+          return EXIT_FAILURE;
+        }
+      }
+      compilerOptions.setCPUThreads(val);
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-cpu-async") {
+      assert(i<(argc-1) && "Mandatory async specification for -cpu-async switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setAsyncCPUKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setAsyncCPUKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid async specification for -cpu-async switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-cpu-tile") {
+      assert(i<(argc-1) && "Mandatory tile specification for -cpu-tile switch missing.");
+      if (StringRef(argv[i+1]) == "auto") {
+        compilerOptions.setCPUTile(AUTO);
+      } else if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setCPUTile(USER_OFF);
+      } else {
+        int x=0, y=0, ret=0;
+        ret = sscanf(argv[i+1], "%dx%d", &x, &y);
+        if (ret!=2 || x < 1 || y < 0) {
+          llvm::errs() << "ERROR: Expected valid tile specification for -cpu-tile switch.\n\n";
+          printUsage();
+          return EXIT_FAILURE;
+        }
+        compilerOptions.setCPUTile(x, y);
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-fuse") {
+      assert(i<(argc-1) && "Mandatory fusion specification for -fuse switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setFuseKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setFuseKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid fusion specification for -fuse switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-stream") {
+      assert(i<(argc-1) && "Mandatory streaming specification for -stream switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setStreamKernels(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setStreamKernels(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid streaming specification for -stream switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
+    if (StringRef(argv[i]) == "-rotate") {
+      assert(i<(argc-1) && "Mandatory rotation specification for -rotate switch missing.");
+      if (StringRef(argv[i+1]) == "off") {
+        compilerOptions.setRotateWindows(USER_OFF);
+      } else if (StringRef(argv[i+1]) == "on") {
+        compilerOptions.setRotateWindows(USER_ON);
+      } else {
+        llvm::errs() << "ERROR: Expected valid rotation specification for -rotate switch.\n\n";
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      ++i;
+      continue;
+    }
     if (StringRef(argv[i]) == "-rs-package") {
       assert(i<(argc-1) && "Mandatory package name string for -rs-package switch missing.");
       compilerOptions.setRSPackageName(argv[i+1]);
@@ -399,6 +514,52 @@ int main(int argc, char *argv[]) {
     }
     compilerOptions.setLocalMemory(USER_OFF);
   }
+  // Multithreading only supported for C/C++ code generation
+  if (compilerOptions.useCPUThreads(USER_ON) && !compilerOptions.emitC99()) {
+    llvm::errs() << "Warning: multiple CPU threads are only supported for C/C++ code generation!\n"
+                 << "  Ignoring -cpu-threads!\n";
+    compilerOptions.setCPUThreads(1);
+  }
+  // Exploration of C/C++ kernels tunes the number of row bands executed by the
+  // thread pool; use all hardware threads unless -cpu-threads was given
+  if (compilerOptions.emitC99() && compilerOptions.exploreConfig() &&
+      !compilerOptions.useCPUThreads(static_cast<CompilerOption>(USER_ON|USER_OFF))) {
+    compilerOptions.setCPUThreads(0);
+  }
+  // Asynchronous launches require multiple CPU threads
+  if (compilerOptions.asyncCPUKernels(USER_ON) && (!compilerOptions.useCPUThreads() ||
+      compilerOptions.timeKernels() || compilerOptions.exploreConfig())) {
+    llvm::errs() << "Warning: asynchronous kernel launches are only supported for C/C++ code generation with multiple CPU threads and without timing or exploration!\n"
+                 << "  Ignoring -cpu-async!\n";
+    compilerOptions.setAsyncCPUKernels(OFF);
+  }
+  // Cache blocking only supported for C/C++ code generation
+  if (compilerOptions.useCPUTile(USER_ON) && !compilerOptions.emitC99()) {
+    llvm::errs() << "Warning: cache blocking is only supported for C/C++ code generation!\n"
+                 << "  Ignoring -cpu-tile!\n";
+  }
+  if (!compilerOptions.emitC99()) {
+    compilerOptions.setCPUTile(OFF);
+  }
+  // Kernel fusion only supported for C/C++ code generation
+  if (compilerOptions.fuseKernels(USER_ON) && !compilerOptions.emitC99()) {
+    llvm::errs() << "Warning: kernel fusion is only supported for C/C++ code generation!\n"
+                 << "  Ignoring -fuse!\n";
+    compilerOptions.setFuseKernels(OFF);
+  }
+  // Streaming of kernel chains only supported for C/C++ code generation
+  if (compilerOptions.streamKernels(USER_ON) && (!compilerOptions.emitC99() ||
+      compilerOptions.timeKernels() || compilerOptions.exploreConfig())) {
+    llvm::errs() << "Warning: streaming of kernel chains is only supported for C/C++ code generation without timing or exploration!\n"
+                 << "  Ignoring -stream!\n";
+    compilerOptions.setStreamKernels(OFF);
+  }
+  // Rotation of sliding windows only supported for C/C++ code generation
+  if (compilerOptions.rotateWindows(USER_ON) && !compilerOptions.emitC99()) {
+    llvm::errs() << "Warning: rotation of sliding windows is only supported for C/C++ code generation!\n"
+                 << "  Ignoring -rotate!\n";
+    compilerOptions.setRotateWindows(OFF);
+  }
   if (compilerOptions.timeKernels(USER_ON) &&
       compilerOptions.exploreConfig(USER_ON)) {
     // kernels are timed internally by the runtime in case of exploration
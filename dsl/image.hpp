@@ -140,6 +140,7 @@ class Image {
         }
 
     template<typename> friend class Accessor;
+    template<typename, typename> friend class Kernel;
 };
 
 
@@ -242,9 +243,8 @@ template<typename data_t>
 class Interpolation {
     protected:
         const Interpolate imode;
-        // dummy reference to return a reference for interpolation
-        data_t interpol_init;
-        data_t &interpol_val;
+        // dummy to return a reference for interpolation, one per thread
+        WorkerLocal<data_t> interpol_val;
 
         virtual data_t &pixel_bh(int x, int y) = 0;
 
@@ -295,7 +295,7 @@ class Interpolation {
 
     public:
         explicit Interpolation(const Interpolate imode) :
-            imode(imode), interpol_init(), interpol_val(interpol_init) {}
+            imode(imode), interpol_val() {}
         Interpolation() : Interpolation(Interpolate::NO) {}
 
         data_t &interpolate(ElementIterator *EI, const int offset_x, const int offset_y, const int width, const int height,
@@ -318,10 +318,10 @@ class Interpolation {
                 case Interpolate::NO:
                     return pixel_bh(EI->x() - EI->offset_x() + offset_x + xf, EI->y() - EI->offset_y() + offset_y + yf);
                 case Interpolate::NN:
-                    interpol_val = pixel_bh(x_mapped, y_mapped);
+                    interpol_val.get() = pixel_bh(x_mapped, y_mapped);
                     break;
                 case Interpolate::LF:
-                    interpol_val = convert<data_t>(
+                    interpol_val.get() = convert<data_t>(
                         (1.0f - x_frac) * (1.0f - y_frac) * as_float(pixel_bh(x_int    , y_int)) +
                                 x_frac  * (1.0f - y_frac) * as_float(pixel_bh(x_int + 1, y_int)) +
                         (1.0f - x_frac) *         y_frac  * as_float(pixel_bh(x_int    , y_int + 1)) +
@@ -345,7 +345,7 @@ class Interpolation {
                               as_float(pixel_bh(x_int - 1 + 2, y_int - 1 + 3)) * bicubic_spline(x_frac - 1 + 2) +
                               as_float(pixel_bh(x_int - 1 + 3, y_int - 1 + 3)) * bicubic_spline(x_frac - 1 + 3);
 
-                    interpol_val = convert<data_t>(
+                    interpol_val.get() = convert<data_t>(
                             y0 * bicubic_spline(y_frac - 1 + 0) +
                             y1 * bicubic_spline(y_frac - 1 + 1) +
                             y2 * bicubic_spline(y_frac - 1 + 2) +
@@ -390,7 +390,7 @@ class Interpolation {
                               as_float(pixel_bh(x_int - 2 + 4, y_int - 1 + 5)) * lanczos(x_frac - 2 + 4) +
                               as_float(pixel_bh(x_int - 2 + 5, y_int - 1 + 5)) * lanczos(x_frac - 2 + 5);
 
-                    interpol_val = convert<data_t>(
+                    interpol_val.get() = convert<data_t>(
                             y0 * lanczos(y_frac - 2 + 0) +
                             y1 * lanczos(y_frac - 2 + 1) +
                             y2 * lanczos(y_frac - 2 + 2) +
@@ -401,7 +401,7 @@ class Interpolation {
                 }
             }
 
-            return interpol_val;
+            return interpol_val.get();
         }
 };
 
@@ -410,7 +410,7 @@ class AccessorBase {
     protected:
         const int width_, height_;
         const int offset_x_, offset_y_;
-        ElementIterator *EI;
+        IteratorRef<ElementIterator> EI;
 
         void set_iterator(ElementIterator *ei) { EI = ei; }
 
@@ -420,10 +420,10 @@ class AccessorBase {
             height_(height),
             offset_x_(offset_x),
             offset_y_(offset_y),
-            EI(nullptr)
+            EI()
         {}
 
-    template<typename> friend class Kernel;
+    template<typename, typename> friend class Kernel;
 };
 
 
@@ -573,7 +573,7 @@ class Accessor : public AccessorBase, BoundaryCondition<data_t>, Interpolation<d
         }
 
     template<typename> friend class Image;
-    template<typename> friend class Kernel;
+    template<typename, typename> friend class Kernel;
 };
 
 } // end namespace hipacc
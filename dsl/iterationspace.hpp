@@ -28,12 +28,49 @@
 #ifndef __ITERATIONSPACE_HPP__
 #define __ITERATIONSPACE_HPP__
 
+#include <algorithm>
+
 #include "image.hpp"
 
 namespace hipacc {
 // forward declaration
 template<typename data_t> class Image;
 
+// maximal number of threads executing a kernel
+constexpr int hipacc_max_workers = 64;
+
+// index of the thread executing the current band of a kernel
+inline int &hipacc_worker_id() {
+    static thread_local int worker_id = 0;
+    return worker_id;
+}
+
+// value kept separately for each thread executing a kernel, e.g. the iterator
+// registered at an Accessor
+template<typename T>
+class WorkerLocal {
+    private:
+        T values_[hipacc_max_workers];
+
+    public:
+        WorkerLocal() : values_() {}
+
+        T &get() { return values_[hipacc_worker_id()]; }
+        const T &get() const { return values_[hipacc_worker_id()]; }
+};
+
+template<typename Iterator>
+class IteratorRef : public WorkerLocal<Iterator *> {
+    public:
+        IteratorRef &operator=(Iterator *iter) {
+            this->get() = iter;
+            return *this;
+        }
+
+        operator Iterator *() const { return this->get(); }
+        Iterator *operator->() const { return this->get(); }
+};
+
 class Coordinate {
     public:
         int x, y;
@@ -60,17 +97,25 @@ class IterationSpaceBase {
             protected:
                 const int min_x, min_y;
                 const int max_x, max_y;
+                const int end_y;
                 const IterationSpaceBase *iteration_space;
                 Coordinate coord;
 
             public:
                 ElementIterator(const int width=0, const int height=0, const int offset_x=0, const int offset_y=0, const IterationSpaceBase *iteration_space=nullptr) :
+                    ElementIterator(width, height, offset_x, offset_y, iteration_space, 0, height)
+                {}
+
+                // iterate only over the rows [first_row, last_row) of the
+                // iteration space
+                ElementIterator(const int width, const int height, const int offset_x, const int offset_y, const IterationSpaceBase *iteration_space, const int first_row, const int last_row) :
                     min_x(offset_x),
                     min_y(offset_y),
                     max_x(offset_x+width),
                     max_y(offset_y+height),
-                    iteration_space(iteration_space),
-                    coord(offset_x, offset_y)
+                    end_y(offset_y+last_row),
+                    iteration_space(first_row < last_row ? iteration_space : nullptr),
+                    coord(offset_x, offset_y+first_row)
                 {}
 
                 // increment so we iterate over elements in a block
@@ -80,7 +125,7 @@ class IterationSpaceBase {
                         if (coord.x >= max_x) {
                             coord.x = min_x;
                             coord.y++;
-                            if (coord.y >= max_y) {
+                            if (coord.y >= end_y) {
                                 iteration_space = nullptr;
                             }
                         }
@@ -101,6 +146,9 @@ class IterationSpaceBase {
         ElementIterator begin() const {
             return ElementIterator(width_, height_, offset_x_, offset_y_, this);
         }
+        ElementIterator begin(const int first_row, const int last_row) const {
+            return ElementIterator(width_, height_, offset_x_, offset_y_, this, first_row, last_row);
+        }
         ElementIterator end() const { return ElementIterator(); }
 
         int width()    const { return width_; }
@@ -133,7 +181,7 @@ class IterationSpace : public IterationSpaceBase {
 
         ~IterationSpace() {}
 
-    template<typename> friend class Kernel;
+    template<typename, typename> friend class Kernel;
 };
 
 // provide shortcut for ElementIterator
@@ -28,6 +28,10 @@
 #ifndef __KERNEL_HPP__
 #define __KERNEL_HPP__
 
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "iterationspace.hpp"
@@ -38,6 +42,45 @@ int64_t hipacc_time_micro() {
     return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
 }
 
+// number of threads executing kernels: HIPACC_DSL_THREADS or all hardware
+// threads; kernels modifying their own members require HIPACC_DSL_THREADS=1
+inline int hipacc_num_threads() {
+    static const int num_threads = [] {
+        const char *env = std::getenv("HIPACC_DSL_THREADS");
+        int num = env ? std::atoi(env) : (int)std::thread::hardware_concurrency();
+        return std::min(std::max(num, 1), hipacc_max_workers);
+    }();
+    return num_threads;
+}
+
+// rows per band of the iteration space; bands do not depend on the number of
+// threads, so that the result of reductions does not either
+constexpr int hipacc_band_rows = 16;
+
+// call body(band, first_row, last_row) for all bands of rows; band b is
+// processed by thread b % num_threads
+template<typename Function>
+void hipacc_for_each_band(const int height, const Function &body) {
+    const int num_bands = (height + hipacc_band_rows - 1) / hipacc_band_rows;
+    const int num_threads = std::min(hipacc_num_threads(), num_bands);
+
+    auto worker = [&] (const int worker_id) {
+        hipacc_worker_id() = worker_id;
+        for (int band=worker_id; band<num_bands; band+=num_threads) {
+            body(band, band*hipacc_band_rows,
+                 std::min((band+1)*hipacc_band_rows, height));
+        }
+        hipacc_worker_id() = 0;
+    };
+
+    std::vector<std::thread> threads;
+    for (int i=1; i<num_threads; ++i)
+        threads.emplace_back(worker, i);
+    worker(0);
+    for (auto &thread : threads)
+        thread.join();
+}
+
 enum class Reduce : uint8_t {
     SUM = 0,
     MIN,
@@ -46,13 +89,74 @@ enum class Reduce : uint8_t {
     MEDIAN
 };
 
-template<typename data_t>
+// direction of Kernel::scan(): along rows, along columns, or both, which
+// yields integral images for Reduce::SUM-like reduce functions
+enum class Scan : uint8_t {
+    ROW = 0,
+    COLUMN,
+    IMAGE
+};
+
+// median of values, the lower median for an even number of values
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, T>::type
+select_median(std::vector<T> &values) {
+    auto mid = values.begin() + (values.size() - 1) / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+// vector types have no ordering: sort values per channel with an odd-even
+// transposition network of min/max operations
+template<typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value, T>::type
+select_median(std::vector<T> &values) {
+    for (size_t pass = 0; pass < values.size(); ++pass) {
+        for (size_t i = pass & 1; i + 1 < values.size(); i += 2) {
+            T lo = hipacc::math::min(values[i], values[i + 1]);
+            values[i + 1] = hipacc::math::max(values[i], values[i + 1]);
+            values[i] = lo;
+        }
+    }
+    return values[(values.size() - 1) / 2];
+}
+
+// Kernels with bins of type bin_t: binning(x, y, pixel) is called for each
+// pixel of the output image after execute() and contributes values to bins,
+// bin(idx) = value. Each thread has private bins, starting at bin_t(), which
+// are combined with reduce(left, right); contributions to bins beyond
+// num_bins are dropped.
+template<typename data_t, typename bin_t=data_t>
 class Kernel {
     private:
         const IterationSpace<data_t> &iteration_space_;
         Accessor<data_t> output_;
         std::vector<AccessorBase *> inputs_;
         data_t reduction_result_;
+        std::vector<std::vector<bin_t>> thread_bins_;
+        std::vector<bin_t> bins_;
+
+        // the global reduction needs bins of the pixel type
+        void apply_reduction(std::true_type) { reduce(); }
+        void apply_reduction(std::false_type) {}
+
+    protected:
+        // contribution to a bin, combined with the bin by reduce()
+        class BinReference {
+            private:
+                const Kernel &kernel_;
+                bin_t *bin_;
+
+            public:
+                BinReference(const Kernel &kernel, bin_t *bin) :
+                    kernel_(kernel), bin_(bin) {}
+
+                BinReference &operator=(const bin_t &value) {
+                    if (bin_)
+                        *bin_ = kernel_.reduce(*bin_, value);
+                    return *this;
+                }
+        };
 
     public:
         explicit Kernel(IterationSpace<data_t> &iteration_space) :
@@ -64,53 +168,89 @@ class Kernel {
 
         virtual ~Kernel() {}
         virtual void kernel() = 0;
-        virtual data_t reduce(data_t left, data_t right) const { return left; }
+        virtual bin_t reduce(bin_t left, bin_t right) const { return left; }
+        virtual void binning(unsigned x, unsigned y, data_t pixel) {}
 
+        // Accessors written at the current pixel, acc() = value, are
+        // additional outputs of the kernel
         void add_accessor(AccessorBase *acc) { inputs_.push_back(acc); }
 
         void execute() {
-            auto end  = iteration_space_.end();
-            auto iter = iteration_space_.begin();
-            // register input & output accessors
-            for (auto acc : inputs_)
-                acc->set_iterator(&iter);
-            output_.set_iterator(&iter);
-
-            // advance iterator and apply kernel to whole iteration space
+            // apply kernel to bands of the iteration space in parallel
             auto start_time = hipacc_time_micro();
-            while (iter != end) {
-                kernel();
-                ++iter;
-            }
+            hipacc_for_each_band(iteration_space_.height(),
+                    [&] (int, int first_row, int last_row) {
+                auto end  = iteration_space_.end();
+                auto iter = iteration_space_.begin(first_row, last_row);
+
+                // register input & output accessors for this thread
+                for (auto acc : inputs_)
+                    acc->set_iterator(&iter);
+                output_.set_iterator(&iter);
+
+                // advance iterator and apply kernel to the band
+                while (iter != end) {
+                    kernel();
+                    ++iter;
+                }
+
+                // de-register input & output accessors
+                for (auto acc : inputs_)
+                    acc->set_iterator(nullptr);
+                output_.set_iterator(nullptr);
+            });
             auto end_time = hipacc_time_micro();
             hipacc_last_timing = (float)(end_time - start_time)/1000.0f;
 
-            // de-register input & output accessors
-            for (auto acc : inputs_)
-                acc->set_iterator(nullptr);
-            output_.set_iterator(nullptr);
-
             // apply reduction
-            reduce();
+            apply_reduction(std::is_same<data_t, bin_t>());
         }
 
         void reduce() {
-            auto end  = iteration_space_.end();
-            auto iter = iteration_space_.begin();
+            const int height = iteration_space_.height();
+
+            // reduce the rows [first_row, last_row) of the iteration space
+            auto reduce_rows = [&] (int first_row, int last_row) -> data_t {
+                auto end  = iteration_space_.end();
+                auto iter = iteration_space_.begin(first_row, last_row);
+
+                // register output accessor for this thread
+                output_.set_iterator(&iter);
+
+                // first element
+                data_t result = output_();
+
+                // advance iterator and apply kernel to the rows
+                while (++iter != end) {
+                    result = reduce(result, output_());
+                }
 
-            // register output accessor
-            output_.set_iterator(&iter);
+                // de-register output accessor
+                output_.set_iterator(nullptr);
 
-            // first element
-            data_t result = output_();
+                return result;
+            };
 
-            // advance iterator and apply kernel to whole iteration space
-            while (++iter != end) {
-                result = reduce(result, output_());
+            // floating-point reductions are not associative; reduce them
+            // sequentially to get the same result as before
+            if (!std::is_integral<data_t>::value) {
+                reduction_result_ = reduce_rows(0, height);
+                return;
             }
 
-            // de-register output accessor
-            output_.set_iterator(nullptr);
+            // reduce each band of the iteration space in parallel
+            const int num_bands = (height + hipacc_band_rows - 1) / hipacc_band_rows;
+            std::vector<data_t> partial(num_bands);
+            hipacc_for_each_band(height,
+                    [&] (int band, int first_row, int last_row) {
+                partial[band] = reduce_rows(first_row, last_row);
+            });
+
+            // combine partial results in order of the bands
+            data_t result = partial[0];
+            for (int band=1; band<num_bands; ++band) {
+                result = reduce(result, partial[band]);
+            }
 
             reduction_result_ = result;
         }
@@ -119,6 +259,101 @@ class Kernel {
             return reduction_result_;
         }
 
+        // inclusive scan of the output image in place, combining pixels by
+        // reduce(left, right); reduce has to be associative, and for
+        // Scan::IMAGE also commutative. Each band of rows is scanned on its
+        // own, the last row of each band is carried into the next band, and
+        // the carry is applied to the rows of the bands in parallel.
+        void scan(Scan mode) {
+            static_assert(std::is_same<data_t, bin_t>::value,
+                          "scan() requires a reduce function of the pixel type");
+            const int width = iteration_space_.width();
+            const int height = iteration_space_.height();
+            const int offset_x = iteration_space_.offset_x();
+            const int offset_y = iteration_space_.offset_y();
+            Image<data_t> &img = iteration_space_.img;
+            auto pixel = [&] (int x, int y) -> data_t & {
+                return img.pixel(x + offset_x, y + offset_y);
+            };
+
+            // scan the rows, and the columns within each band
+            hipacc_for_each_band(height,
+                    [&] (int, int first_row, int last_row) {
+                for (int y=first_row; y<last_row; ++y) {
+                    if (mode != Scan::COLUMN) {
+                        for (int x=1; x<width; ++x)
+                            pixel(x, y) = reduce(pixel(x-1, y), pixel(x, y));
+                    }
+                    if (mode != Scan::ROW && y > first_row) {
+                        for (int x=0; x<width; ++x)
+                            pixel(x, y) = reduce(pixel(x, y-1), pixel(x, y));
+                    }
+                }
+            });
+            if (mode == Scan::ROW)
+                return;
+
+            // carry the last row of each band into the last row of the next
+            const int num_bands = (height + hipacc_band_rows - 1) / hipacc_band_rows;
+            for (int band=1; band<num_bands; ++band) {
+                int carry = band*hipacc_band_rows - 1;
+                int last = std::min((band+1)*hipacc_band_rows, height) - 1;
+                for (int x=0; x<width; ++x)
+                    pixel(x, last) = reduce(pixel(x, carry), pixel(x, last));
+            }
+
+            // apply the carry to the other rows of each band
+            hipacc_for_each_band(height,
+                    [&] (int band, int first_row, int last_row) {
+                if (!band)
+                    return;
+                for (int y=first_row; y<last_row-1; ++y) {
+                    for (int x=0; x<width; ++x)
+                        pixel(x, y) = reduce(pixel(x, first_row-1), pixel(x, y));
+                }
+            });
+        }
+
+        // compute num_bins bins over the output image
+        bin_t *binned_data(unsigned num_bins) {
+            thread_bins_.assign(hipacc_num_threads(),
+                                std::vector<bin_t>(num_bins, bin_t()));
+
+            // bin the pixels of each band into the bins of its thread
+            hipacc_for_each_band(iteration_space_.height(),
+                    [&] (int, int first_row, int last_row) {
+                auto end  = iteration_space_.end();
+                auto iter = iteration_space_.begin(first_row, last_row);
+
+                // register output accessor for this thread
+                output_.set_iterator(&iter);
+
+                while (iter != end) {
+                    binning(output_.x(), output_.y(), output_());
+                    ++iter;
+                }
+
+                // de-register output accessor
+                output_.set_iterator(nullptr);
+            });
+
+            // combine the bins of the threads in order
+            bins_ = thread_bins_[0];
+            for (size_t thread=1; thread<thread_bins_.size(); ++thread) {
+                for (unsigned idx=0; idx<num_bins; ++idx)
+                    bins_[idx] = reduce(bins_[idx], thread_bins_[thread][idx]);
+            }
+            thread_bins_.clear();
+
+            return bins_.data();
+        }
+
+        // contribute to bin idx of the current thread in binning()
+        BinReference bin(unsigned idx) {
+            std::vector<bin_t> &bins = thread_bins_[hipacc_worker_id()];
+            return BinReference(*this, idx < bins.size() ? &bins[idx] : nullptr);
+        }
+
 
         // access output image
         data_t &output() {
@@ -132,12 +367,12 @@ class Kernel {
         }
 
         int x() const {
-            assert(output_.EI!=ElementIterator() && "ElementIterator not set!");
+            assert(output_.EI && "ElementIterator not set!");
             return output_.x();
         }
 
         int y() const {
-            assert(output_.EI!=ElementIterator() && "ElementIterator not set!");
+            assert(output_.EI && "ElementIterator not set!");
             return output_.y();
         }
 
@@ -151,14 +386,27 @@ class Kernel {
 };
 
 
-template <typename data_t> template <typename data_m, typename Function>
-auto Kernel<data_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& fun) -> decltype(fun()) {
+template <typename data_t, typename bin_t> template <typename data_m, typename Function>
+auto Kernel<data_t, bin_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& fun) -> decltype(fun()) {
     auto end  = mask.end();
     auto iter = mask.begin();
 
     // register mask
     mask.set_iterator(&iter);
 
+    // median requires all values of the iteration space
+    if (mode == Reduce::MEDIAN) {
+        std::vector<decltype(fun())> values;
+        do {
+            values.push_back(fun());
+        } while (++iter != end);
+
+        // de-register mask
+        mask.set_iterator(nullptr);
+
+        return select_median(values);
+    }
+
     // initialize result - calculate first iteration
     auto result = fun();
 
@@ -169,7 +417,7 @@ auto Kernel<data_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& f
             case Reduce::MIN:    result  = hipacc::math::min(fun(), result);         break;
             case Reduce::MAX:    result  = hipacc::math::max(fun(), result);         break;
             case Reduce::PROD:   result *= fun();                                    break;
-            case Reduce::MEDIAN: assert(0 && "Reduce::MEDIAN not implemented yet!"); break;
+            case Reduce::MEDIAN:                                                     break;
         }
     }
 
@@ -180,14 +428,27 @@ auto Kernel<data_t>::convolve(Mask<data_m> &mask, Reduce mode, const Function& f
 }
 
 
-template <typename data_t> template <typename Function>
-auto Kernel<data_t>::reduce(Domain &domain, Reduce mode, const Function &fun) -> decltype(fun()) {
+template <typename data_t, typename bin_t> template <typename Function>
+auto Kernel<data_t, bin_t>::reduce(Domain &domain, Reduce mode, const Function &fun) -> decltype(fun()) {
     auto end  = domain.end();
     auto iter = domain.begin();
 
     // register domain
     domain.set_iterator(&iter);
 
+    // median requires all values of the iteration space
+    if (mode == Reduce::MEDIAN) {
+        std::vector<decltype(fun())> values;
+        do {
+            values.push_back(fun());
+        } while (++iter != end);
+
+        // de-register domain
+        domain.set_iterator(nullptr);
+
+        return select_median(values);
+    }
+
     // initialize result - calculate first iteration
     auto result = fun();
 
@@ -198,7 +459,7 @@ auto Kernel<data_t>::reduce(Domain &domain, Reduce mode, const Function &fun) ->
             case Reduce::MIN:    result  = hipacc::math::min(fun(), result);         break;
             case Reduce::MAX:    result  = hipacc::math::max(fun(), result);         break;
             case Reduce::PROD:   result *= fun();                                    break;
-            case Reduce::MEDIAN: assert(0 && "Reduce::MEDIAN not implemented yet!"); break;
+            case Reduce::MEDIAN:                                                     break;
         }
     }
 
@@ -209,8 +470,8 @@ auto Kernel<data_t>::reduce(Domain &domain, Reduce mode, const Function &fun) ->
 }
 
 
-template <typename data_t> template <typename Function>
-void Kernel<data_t>::iterate(Domain &domain, const Function &fun) {
+template <typename data_t, typename bin_t> template <typename Function>
+void Kernel<data_t, bin_t>::iterate(Domain &domain, const Function &fun) {
     auto end  = domain.end();
     auto iter = domain.begin();
 
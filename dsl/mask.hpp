@@ -143,17 +143,17 @@ class Domain : public MaskBase {
         };
 
     protected:
-        DomainIterator *DI;
+        IteratorRef<DomainIterator> DI;
 
     public:
         Domain(const int size_x, const int size_y) :
             MaskBase(size_x, size_y),
-            DI(nullptr) {}
+            DI() {}
 
         template <int size_y, int size_x>
         explicit Domain(const uchar (&domain)[size_y][size_x]) :
             MaskBase(size_x, size_y),
-            DI(nullptr) {
+            DI() {
                 for (int y=0; y<size_y_; ++y) {
                     for (int x=0; x<size_x_; ++x) {
                         domain_space[y * size_x + x] = domain[y][x];
@@ -163,7 +163,7 @@ class Domain : public MaskBase {
 
         explicit Domain(const MaskBase &mask) :
             MaskBase(mask),
-            DI(nullptr) {}
+            DI() {}
 
         explicit Domain(const Domain &domain) :
             MaskBase(domain),
@@ -228,7 +228,7 @@ class Domain : public MaskBase {
 template<typename data_t>
 class Mask : public MaskBase {
     private:
-        ElementIterator *EI;
+        IteratorRef<ElementIterator> EI;
         data_t *array;
 
         template <int size_y, int size_x>
@@ -251,7 +251,7 @@ class Mask : public MaskBase {
         template <int size_y, int size_x>
         explicit Mask(const data_t (&mask)[size_y][size_x]) :
             MaskBase(size_x, size_y),
-            EI(nullptr),
+            EI(),
             array(new data_t[size_x*size_y])
         {
             init(mask);
@@ -259,7 +259,7 @@ class Mask : public MaskBase {
 
         explicit Mask(const Mask &mask) :
             MaskBase(mask.size_x, mask.size_y),
-            EI(nullptr),
+            EI(),
             array(new data_t[mask.size_x*mask.size_y])
         {
             init(mask.array);
@@ -89,6 +89,10 @@ BinaryOperator *createBinaryOperator(ASTContext &Ctx, Expr *lhs, Expr *rhs,
 CompoundAssignOperator *createCompoundAssignOperator(ASTContext &Ctx, Expr *lhs,
     Expr *rhs, BinaryOperator::Opcode opc, QualType ResTy);
 
+// creates an AST node for conditional operators
+ConditionalOperator *createConditionalOperator(ASTContext &Ctx, Expr *cond,
+    Expr *lhs, Expr *rhs, QualType ResTy);
+
 // creates an AST node for paren expressions
 ParenExpr *createParenExpr(ASTContext &Ctx, Expr *val);
 
@@ -49,6 +49,7 @@
 #include "hipacc/Vectorization/SIMDTypes.h"
 
 #include <functional>
+#include <map>
 
 //===----------------------------------------------------------------------===//
 // Statement/expression transformations
@@ -101,8 +102,76 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     SmallVector<Reduce, 4> redModes;
     SmallVector<int, 4> redIdxX, redIdxY;
 
+    // sum convolutions over separable constant Masks (C/C++): the vertical
+    // pass is stored per row in a line buffer, indexed by gid_x-lower_x+x
+    struct SeparableConvolution {
+      CXXMemberCallExpr *call;
+      HipaccMask *mask;
+      Expr *weighted;
+      QualType type;
+      SmallVector<double, 16> weights_x, weights_y;
+      VarDecl *buffer;
+      Expr *lower_x;
+    };
+    SmallVector<SeparableConvolution, 4> sepConvs;
+
+    // median filters over large Masks for 8-bit data (C/C++): the columns of
+    // the window are stored per row in a line buffer, whose medians are
+    // computed by a sliding histogram into a second line buffer
+    struct MedianFilter {
+      CXXMemberCallExpr *call;
+      HipaccMask *mask;
+      Expr *read;
+      VarDecl *columns, *buffer;
+      Expr *lower_x;
+    };
+    SmallVector<MedianFilter, 4> medianFilters;
+
+    // integer sums over constant Masks with equal coefficients and over
+    // constant rectangular Domains (C/C++): the column sums are kept in a line
+    // buffer and updated incrementally per row, the window sums of the row are
+    // computed by a sliding window into a second line buffer
+    struct SlidingSum {
+      CXXMemberCallExpr *call;
+      HipaccMask *mask;
+      Expr *read, *weight;
+      QualType type;
+      VarDecl *columns, *buffer;
+      Expr *lower_x;
+    };
+    SmallVector<SlidingSum, 4> slidingSums;
+
+    // Reduce::MEDIAN: the value of each iteration is stored in a temporary,
+    // the median is selected afterwards
+    struct MedianSelection {
+      DeclRefExpr *tmp;
+      SmallVector<DeclRefExpr *, 64> values;
+    };
+    SmallVector<MedianSelection, 4> medians;
+
+    // sliding windows along rows (C/C++): pixels of an Accessor row read at
+    // constant offsets from gid_x are kept in registers, which are rotated
+    // after each pixel, so that only the column entering the window is loaded
+    struct SlidingWindow {
+      std::string key;
+      DeclRefExpr *image;
+      Expr *idx_y;
+      SmallVector<std::pair<bool, Expr *>, 4> terms_x;
+      QualType type;
+      std::map<int, VarDecl *> columns;
+    };
+    SmallVector<SlidingWindow, 8> slidingWindows;
+    bool rotateWindows;
+
+    // producer kernel inlined into a consumer kernel (C/C++): its parameters
+    // are prefixed by the name of the Accessor replaced by the producer and
+    // its output is written to a temporary
+    std::string fusedPrefix;
+    VarDecl *fusedOutput;
+
     DeclRefExpr *bh_start_left, *bh_start_right, *bh_start_top,
                 *bh_start_bottom, *bh_fall_back;
+    DeclRefExpr *cpu_start_y, *cpu_end_y;
     DeclRefExpr *outputImage;
     DeclRefExpr *retValRef;
     Expr *writeImageRHS;
@@ -209,6 +278,14 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       Kernel->setUsed(bh_fall_back->getNameInfo().getAsString());
       return bh_fall_back;
     }
+    DeclRefExpr *getCPUStartY() {
+      Kernel->setUsed(cpu_start_y->getNameInfo().getAsString());
+      return cpu_start_y;
+    }
+    DeclRefExpr *getCPUEndY() {
+      Kernel->setUsed(cpu_end_y->getNameInfo().getAsString());
+      return cpu_end_y;
+    }
 
     // KernelDeclMap - this keeps track of the cloned Decls which are used in
     // expressions, e.g. DeclRefExpr
@@ -237,6 +314,21 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
     Stmt *addDomainCheck(HipaccMask *Domain, DeclRefExpr *domain_var, Stmt
         *stmt);
     Expr *convertConvolution(CXXMemberCallExpr *E);
+    bool convertConstantConvolution(HipaccMask *Mask, FieldDecl *FD,
+        LambdaExpr *LE, CompoundStmt *outerCompountStmt);
+    void addMedianSelection(const MedianSelection &median, CompoundStmt
+        *outerCompountStmt);
+    void findSeparableConvolutions(Stmt *S, Expr *lower_x);
+    Stmt *createSeparableRowPass(Expr *start, Expr *end, Expr *lower, Expr
+        *upper, Expr *first_y, bool split_x, bool top, bool bottom);
+
+    // Fusion.cpp
+    Expr *inlineFusedKernel(DeclRefExpr *LHS, const HipaccKernel::FusedKernel
+        *fusion, Expr *idx_x, Expr *idx_y);
+
+    // SlidingWindow.cpp
+    Expr *getWindowRegister(DeclRefExpr *LHS, Expr *idx_x, Expr *idx_y);
+    Stmt *createWindowLoop(Expr *upper, Expr *inc, Stmt *body);
 
     // Interpolation.cpp
     Expr *addNNInterpolationX(HipaccAccessor *Acc, Expr *idx_x);
@@ -323,11 +415,16 @@ class ASTTranslate : public StmtVisitor<ASTTranslate, Stmt *> {
       convTmp(nullptr),
       convIdxX(0),
       convIdxY(0),
+      rotateWindows(false),
+      fusedPrefix(),
+      fusedOutput(nullptr),
       bh_start_left(nullptr),
       bh_start_right(nullptr),
       bh_start_top(nullptr),
       bh_start_bottom(nullptr),
       bh_fall_back(nullptr),
+      cpu_start_y(nullptr),
+      cpu_end_y(nullptr),
       outputImage(nullptr),
       retValRef(nullptr),
       writeImageRHS(nullptr),
@@ -76,6 +76,12 @@ class CompilerOptions {
     // target code features
     CompilerOption explore_config;
     CompilerOption time_kernels;
+    CompilerOption cpu_threads;
+    CompilerOption cpu_async;
+    CompilerOption cpu_tile;
+    CompilerOption fuse_kernels;
+    CompilerOption stream_kernels;
+    CompilerOption rotate_windows;
     // target code features - may be selected by the framework
     CompilerOption kernel_config;
     CompilerOption align_memory;
@@ -87,6 +93,9 @@ class CompilerOptions {
     int kernel_config_x, kernel_config_y;
     int align_bytes;
     int pixels_per_thread;
+    int vector_width;
+    int cpu_threads_num;
+    int cpu_tile_x, cpu_tile_y;
     Texture texture_type;
     std::string rs_package_name, rs_directory;
 
@@ -117,6 +126,12 @@ class CompilerOptions {
       target_device(Device::Kepler_30),
       explore_config(OFF),
       time_kernels(OFF),
+      cpu_threads(OFF),
+      cpu_async(OFF),
+      cpu_tile(OFF),
+      fuse_kernels(OFF),
+      stream_kernels(OFF),
+      rotate_windows(OFF),
       kernel_config(AUTO),
       align_memory(AUTO),
       texture_memory(AUTO),
@@ -127,6 +142,10 @@ class CompilerOptions {
       kernel_config_y(1),
       align_bytes(0),
       pixels_per_thread(1),
+      vector_width(32),
+      cpu_threads_num(1),
+      cpu_tile_x(0),
+      cpu_tile_y(0),
       texture_type(Texture::None),
       rs_package_name("org.hipacc.rs"),
       rs_directory("/data/local/tmp")
@@ -179,10 +198,35 @@ class CompilerOptions {
     bool vectorizeKernels(CompilerOption option=option_ou) {
       return vectorize_kernels & option;
     }
+    // width of SIMD registers in bytes for C/C++ kernels
+    int getVectorWidth() { return vector_width; }
     bool multiplePixelsPerThread(CompilerOption option=option_ou) {
       return multiple_pixels & option;
     }
     int getPixelsPerThread() { return pixels_per_thread; }
+    bool useCPUThreads(CompilerOption option=option_ou) {
+      return cpu_threads & option;
+    }
+    // number of worker threads for C/C++ kernels, 0 selects the number of
+    // hardware threads at run time
+    int getCPUThreads() { return cpu_threads_num; }
+    bool asyncCPUKernels(CompilerOption option=option_ou) {
+      return cpu_async & option;
+    }
+    bool useCPUTile(CompilerOption option=option_aou) {
+      return cpu_tile & option;
+    }
+    int getCPUTileX() { return cpu_tile_x; }
+    int getCPUTileY() { return cpu_tile_y; }
+    bool fuseKernels(CompilerOption option=option_ou) {
+      return fuse_kernels & option;
+    }
+    bool streamKernels(CompilerOption option=option_ou) {
+      return stream_kernels & option;
+    }
+    bool rotateWindows(CompilerOption option=option_ou) {
+      return rotate_windows & option;
+    }
     std::string getRSPackageName() { return rs_package_name; }
     std::string getRSDirectory() { return rs_directory; }
 
@@ -192,6 +236,7 @@ class CompilerOptions {
     void setTimeKernels(CompilerOption o) { time_kernels = o; }
     void setLocalMemory(CompilerOption o) { local_memory = o; }
     void setVectorizeKernels(CompilerOption o) { vectorize_kernels = o; }
+    void setVectorWidth(int bytes) { vector_width = bytes; }
 
     void setTextureMemory(Texture type) {
       texture_type = type;
@@ -217,6 +262,23 @@ class CompilerOptions {
       else multiple_pixels = USER_OFF;
     }
 
+    void setCPUThreads(int threads) {
+      cpu_threads_num = threads;
+      if (threads != 1) cpu_threads = USER_ON;
+      else cpu_threads = USER_OFF;
+    }
+
+    void setAsyncCPUKernels(CompilerOption o) { cpu_async = o; }
+    void setCPUTile(CompilerOption o) { cpu_tile = o; }
+    void setCPUTile(int x, int y) {
+      cpu_tile = USER_ON;
+      cpu_tile_x = x;
+      cpu_tile_y = y;
+    }
+    void setFuseKernels(CompilerOption o) { fuse_kernels = o; }
+    void setStreamKernels(CompilerOption o) { stream_kernels = o; }
+    void setRotateWindows(CompilerOption o) { rotate_windows = o; }
+
     void setRSPackageName(std::string name) {
       rs_package_name = name;
       rs_directory = "/data/data/" + name;
@@ -277,6 +339,27 @@ class CompilerOptions {
       getOptionAsString(multiple_pixels, pixels_per_thread);
       llvm::errs() << "\n  Vectorization of kernels: ";
       getOptionAsString(vectorize_kernels);
+      if (vectorizeKernels() && emitC99()) {
+        llvm::errs() << ": " << vector_width*8 << " bit SIMD registers";
+      }
+      llvm::errs() << "\n  Multithreading of CPU kernels: ";
+      getOptionAsString(cpu_threads, cpu_threads_num ? cpu_threads_num : -1);
+      if (useCPUThreads() && !cpu_threads_num) {
+        llvm::errs() << ": auto";
+      }
+      llvm::errs() << "\n  Asynchronous launches of CPU kernels: ";
+      getOptionAsString(cpu_async);
+      llvm::errs() << "\n  Cache blocking of CPU kernels: ";
+      getOptionAsString(cpu_tile);
+      if (useCPUTile(USER_ON)) {
+        llvm::errs() << ": " << cpu_tile_x << "x" << cpu_tile_y;
+      }
+      llvm::errs() << "\n  Fusion of producer/consumer kernels: ";
+      getOptionAsString(fuse_kernels);
+      llvm::errs() << "\n  Line-buffered streaming of kernel chains: ";
+      getOptionAsString(stream_kernels);
+      llvm::errs() << "\n  Rotation of sliding windows through registers: ";
+      getOptionAsString(rotate_windows);
       llvm::errs() << "\n\n";
     }
 };
@@ -40,6 +40,7 @@
 
 #include <clang/AST/ASTContext.h>
 
+#include <algorithm>
 #include <locale>
 #include <map>
 #include <set>
@@ -76,6 +77,13 @@ enum class Reduce : uint8_t {
   MEDIAN
 };
 
+// scan directions for kernels
+enum class Scan : uint8_t {
+  ROW = 0,
+  COLUMN,
+  IMAGE
+};
+
 // interpolation modes for accessors
 enum class Interpolate : uint8_t {
   NO = 0,
@@ -143,14 +151,25 @@ class HipaccMemory : public HipaccSize {
 class HipaccImage : public HipaccMemory {
   private:
     ASTContext &Ctx;
+    // number of rows held by a ring buffer in streamed kernel chains (C/C++);
+    // 0 if the whole image is allocated
+    unsigned ring_rows;
 
   public:
     HipaccImage(ASTContext &Ctx, VarDecl *VD, QualType QT) :
       HipaccMemory(VD, VD->getNameAsString(), QT),
-      Ctx(Ctx)
+      Ctx(Ctx),
+      ring_rows(0)
     {}
 
     unsigned getPixelSize() { return Ctx.getTypeSize(type)/8; }
+    // rows are addressed modulo the ring size, which is a power of two
+    void setRingRows(unsigned rows) {
+      ring_rows = std::max(ring_rows, 1u);
+      while (ring_rows < rows)
+        ring_rows <<= 1;
+    }
+    unsigned getRingRows() { return ring_rows; }
     std::string getTextureType();
     std::string getImageReadFunction();
 };
@@ -383,7 +402,7 @@ class HipaccKernelClass {
     };
 
     std::string name;
-    CXXMethodDecl *kernelFunction, *reduceFunction;
+    CXXMethodDecl *kernelFunction, *reduceFunction, *binningFunction;
     KernelStatistics *kernelStatistics;
     // kernel member information
     SmallVector<KernelMemberInfo, 16> members;
@@ -397,6 +416,7 @@ class HipaccKernelClass {
       name(name),
       kernelFunction(nullptr),
       reduceFunction(nullptr),
+      binningFunction(nullptr),
       kernelStatistics(nullptr),
       members(0),
       imgFields(0),
@@ -414,8 +434,10 @@ class HipaccKernelClass {
     }
 
     void setReduceFunction(CXXMethodDecl *fun) { reduceFunction = fun; }
+    void setBinningFunction(CXXMethodDecl *fun) { binningFunction = fun; }
     CXXMethodDecl *getKernelFunction() { return kernelFunction; }
     CXXMethodDecl *getReduceFunction() { return reduceFunction; }
+    CXXMethodDecl *getBinningFunction() { return binningFunction; }
 
     KernelStatistics &getKernelStatistics(void) {
       return *kernelStatistics;
@@ -433,6 +455,13 @@ class HipaccKernelClass {
     KernelType getKernelType() {
       return kernelStatistics->getKernelType();
     }
+    // Accessors written by the kernel in addition to the iteration space
+    bool hasAccessorOutputs() {
+      for (auto img : imgFields)
+        if (img != output_image && (getMemAccess(img) & WRITE_ONLY))
+          return true;
+      return false;
+    }
 
     void addArg(FieldDecl *FD, QualType QT, StringRef Name) {
       KernelMemberInfo info = { FieldKind::Normal, FD, QT, Name };
@@ -559,17 +588,28 @@ class HipaccKernelFeatures : public HipaccDevice {
 
 
 class HipaccKernel : public HipaccKernelFeatures {
+  public:
+    // point operator evaluated in place of reading the image of an Accessor;
+    // width and height of the eliminated image are host expressions
+    struct FusedKernel {
+      FieldDecl *field;
+      HipaccKernel *kernel;
+      std::string width, height;
+    };
+
   private:
     ASTContext &Ctx;
     VarDecl *VD;
     std::string name;
-    std::string kernelName, reduceName;
+    std::string kernelName, reduceName, binningName;
     std::string fileName;
-    std::string reduceStr, infoStr;
+    std::string reduceStr, binningStr, infoStr;
     unsigned infoStrCnt;
     HipaccIterationSpace *iterationSpace;
     std::map<FieldDecl *, HipaccAccessor *> imgMap;
     std::map<FieldDecl *, HipaccMask *> maskMap;
+    SmallVector<FusedKernel, 2> fusedKernels;
+    bool streamed;
     SmallVector<QualType, 16> argTypes;
     SmallVector<std::string, 16> argTypeNames;
     SmallVector<std::string, 16> hostArgNames;
@@ -603,12 +643,15 @@ class HipaccKernel : public HipaccKernelFeatures {
       name(VD->getNameAsString()),
       kernelName(options.getTargetPrefix() + KC->getName() + name + "Kernel"),
       reduceName(options.getTargetPrefix() + KC->getName() + name + "Reduce"),
+      binningName(options.getTargetPrefix() + KC->getName() + name + "Binning"),
       fileName(options.getTargetPrefix() + KC->getName() + VD->getNameAsString()),
-      reduceStr(), infoStr(),
+      reduceStr(), binningStr(), infoStr(),
       infoStrCnt(0),
       iterationSpace(nullptr),
       imgMap(),
       maskMap(),
+      fusedKernels(),
+      streamed(false),
       argTypes(),
       argTypeNames(),
       hostArgNames(),
@@ -641,9 +684,11 @@ class HipaccKernel : public HipaccKernelFeatures {
     const std::string &getName() const { return name; }
     const std::string &getKernelName() const { return kernelName; }
     const std::string &getReduceName() const { return reduceName; }
+    const std::string &getBinningName() const { return binningName; }
     const std::string &getFileName() const { return fileName; }
     const std::string &getInfoStr() const { return infoStr; }
     const std::string &getReduceStr() const { return reduceStr; }
+    const std::string &getBinningStr() const { return binningStr; }
 
     // keep track of variables used within kernel
     void setUsed(std::string name) { usedVars.insert(name); }
@@ -652,6 +697,9 @@ class HipaccKernel : public HipaccKernelFeatures {
       deviceFuncs.clear();
       for (auto map : imgMap)
         map.second->resetDecls();
+      for (auto &fusion : fusedKernels)
+        for (auto map : fusion.kernel->imgMap)
+          map.second->resetDecls();
     }
     bool getUsed(std::string name) {
       return usedVars.find(name) != usedVars.end();
@@ -679,8 +727,13 @@ class HipaccKernel : public HipaccKernelFeatures {
 
     HipaccAccessor *getImgFromMapping(FieldDecl *decl) {
       auto iter = imgMap.find(decl);
-      if (iter == imgMap.end())
+      if (iter == imgMap.end()) {
+        // Accessors read by fused producer kernels
+        for (auto &fusion : fusedKernels)
+          if (auto acc = fusion.kernel->getImgFromMapping(decl))
+            return acc;
         return nullptr;
+      }
       return iter->second;
     }
     HipaccMask *getMaskFromMapping(FieldDecl *decl) {
@@ -690,6 +743,23 @@ class HipaccKernel : public HipaccKernelFeatures {
       return iter->second;
     }
 
+    void insertFusion(FieldDecl *decl, HipaccKernel *K, std::string width,
+        std::string height) {
+      FusedKernel fusion = { decl, K, width, height };
+      fusedKernels.push_back(fusion);
+    }
+    ArrayRef<FusedKernel> getFusedKernels() { return fusedKernels; }
+    const FusedKernel *getFusedKernel(FieldDecl *decl) {
+      for (auto &fusion : fusedKernels)
+        if (fusion.field == decl)
+          return &fusion;
+      return nullptr;
+    }
+
+    // kernel executed row by row as stage of a streamed kernel chain
+    void setStreamed(bool s) { streamed = s; }
+    bool isStreamed() { return streamed; }
+
     ArrayRef<QualType> getArgTypes() {
       createArgInfo();
       return argTypes;
@@ -707,6 +777,7 @@ class HipaccKernel : public HipaccKernelFeatures {
       std::string cnt(std::to_string(infoStrCnt++));
       infoStr = name + "_info" + cnt;
       reduceStr = name + "_red" + cnt;
+      binningStr = name + "_bins" + cnt;
       createArgInfo();
       createHostArgInfo(hostArgs, hostLiterals, literalCount);
     }
@@ -68,6 +68,15 @@ class HipaccDeviceOptions {
       switch (options.getTargetDevice()) {
         case Device::CPU:
           alignment = 8;
+          local_memory_threshold = 9999;
+          pixels_per_thread[PointOperator] = 1;
+          pixels_per_thread[LocalOperator] = 1;
+          pixels_per_thread[GlobalOperator] = 1;
+          require_textures[PointOperator] = Texture::None;
+          require_textures[LocalOperator] = Texture::None;
+          require_textures[GlobalOperator] = Texture::None;
+          require_textures[UserOperator] = Texture::None;
+          vectorization = false;
           break;
         case Device::Fermi_20:
         case Device::Fermi_21:
@@ -203,6 +212,9 @@ class HipaccDevice : public HipaccDeviceOptions {
     unsigned max_total_shared_memory;
     unsigned max_register_per_thread;
 
+    // CPU only device properties
+    unsigned l2_cache_size;
+
     // NVIDIA only device properties
     unsigned num_alus;
     unsigned num_sfus;
@@ -213,11 +225,14 @@ class HipaccDevice : public HipaccDeviceOptions {
       target_device(options.getTargetDevice()),
       max_threads_per_warp(32),
       max_blocks_per_multiprocessor(8),
+      l2_cache_size(0),
       num_alus(0),
       num_sfus(0)
     {
       switch (target_device) {
         case Device::CPU:
+          // per core
+          l2_cache_size = 262144;
           break;
         case Device::Fermi_20:
           max_threads_per_block = 1024;
@@ -92,6 +92,12 @@ class CreateHostStrings {
         is_pyramid=false);
     void writeKernelCall(HipaccKernel *K, std::string &resultStr);
     void writeReduceCall(HipaccKernel *K, std::string &resultStr);
+    void writeBinningDeclaration(HipaccKernel *K, std::string &resultStr);
+    void writeBinningCall(HipaccKernel *K, std::string num_bins, std::string
+        weight, std::string &resultStr);
+    void writeScanCall(HipaccKernel *K, Scan mode, std::string &resultStr);
+    void writeStreamCall(ArrayRef<HipaccKernel *> stages, ArrayRef<unsigned>
+        lags, std::string &resultStr);
     std::string getInterpolationDefinition(HipaccKernel *K, HipaccAccessor *Acc,
         std::string function_name, std::string type_suffix, Interpolate ip_mode,
         Boundary bh_mode);
@@ -301,6 +301,13 @@ CompoundAssignOperator *createCompoundAssignOperator(ASTContext &Ctx, Expr *lhs,
 }
 
 
+ConditionalOperator *createConditionalOperator(ASTContext &Ctx, Expr *cond,
+    Expr *lhs, Expr *rhs, QualType ResTy) {
+  return new (Ctx) ConditionalOperator(cond, SourceLocation(), lhs,
+      SourceLocation(), rhs, ResTy, VK_RValue, OK_Ordinary);
+}
+
+
 ParenExpr *createParenExpr(ASTContext &Ctx, Expr *val) {
   return new (Ctx) ParenExpr(SourceLocation(), SourceLocation(), val);
 }
@@ -174,8 +174,11 @@ void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
         createIntegerLiteral(Ctx, 0));
   }
 
-  // C/C++: int gid_y = offset_y;
-  if (Kernel->getIterationSpace()->getOffsetYDecl()) {
+  // C/C++: int gid_y = cpu_start_y; or int gid_y = offset_y;
+  if (cpu_start_y) {
+    gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
+        getCPUStartY());
+  } else if (Kernel->getIterationSpace()->getOffsetYDecl()) {
     gid_y = createVarDecl(Ctx, kernelDecl, "gid_y", Ctx.IntTy,
         getOffsetYDecl(Kernel->getIterationSpace()));
   } else {
@@ -203,27 +206,46 @@ void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   tileVars.local_size_y = createIntegerLiteral(Ctx, 0);
 
   // check if we need border handling
+  bool kernel_x = false;
+  bool kernel_y = false;
+  bool split_regions = true;
   if (KernelClass->getKernelType() != UserOperator) {
     for (auto img : KernelClass->getImgFields()) {
       HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
 
       // check if we need border handling
       if (Acc->getBoundaryMode() != Boundary::UNDEFINED) {
-        if (Acc->getSizeX() > 1) {
-          bh_variant.borders.left = 1;
-          bh_variant.borders.right = 1;
-        }
-        if (Acc->getSizeY() > 1) {
-          bh_variant.borders.top = 1;
-          bh_variant.borders.bottom = 1;
-        }
+        if (Acc->getSizeX() > 1) kernel_x = true;
+        if (Acc->getSizeY() > 1) kernel_y = true;
+        // interpolated accessors do not map the interior of the iteration
+        // space to the interior of the image
+        if ((Acc->getSizeX() > 1 || Acc->getSizeY() > 1) &&
+            Acc->getInterpolationMode() != Interpolate::NO)
+          split_regions = false;
       }
     }
   }
 
-  // convert the function body to kernel syntax
-  Stmt *new_body = Clone(S);
-  assert(isa<CompoundStmt>(new_body) && "CompoundStmt for kernel function body expected!");
+  // number of pixels per SIMD register; column loops without boundary
+  // handling in x are strip-mined into chunks of that many lanes
+  int simd_width = 1;
+  if (Kernel->vectorize() && KernelClass->getKernelType() != UserOperator) {
+    int64_t pixel_size = Ctx.getTypeSizeInChars(
+        Kernel->getIterationSpace()->getImage()->getType()).getQuantity();
+    for (auto img : KernelClass->getImgFields()) {
+      HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
+      pixel_size = std::max(pixel_size, Ctx.getTypeSizeInChars(
+            Acc->getImage()->getType()).getQuantity());
+    }
+    simd_width = compilerOptions.getVectorWidth() / pixel_size;
+    if (simd_width < 2) {
+      llvm::errs() << "Warning: pixels of kernel '" << Kernel->getKernelName()
+                   << "' (" << pixel_size << " bytes) do not fit twice into "
+                   << compilerOptions.getVectorWidth()*8
+                   << " bit SIMD registers, kernel is not vectorized!\n";
+      simd_width = 1;
+    }
+  }
 
   //
   // for (int gid_y=offset_y; gid_y<is_height+offset_y; gid_y++) {
@@ -231,27 +253,408 @@ void ASTTranslate::initCPU(SmallVector<Stmt *, 16> &kernelBody, Stmt *S) {
   //         body
   //     }
   // }
+  // In case of multiple threads, each thread processes only the band of rows
+  // [cpu_start_y, cpu_end_y), which already includes offset_y.
   //
+  Expr *lower_x = gid_x->getInit();
   Expr *upper_x = getWidthDecl(Kernel->getIterationSpace());
-  Expr *upper_y = getHeightDecl(Kernel->getIterationSpace());
+  Expr *upper_y = cpu_end_y ? getCPUEndY() :
+    getHeightDecl(Kernel->getIterationSpace());
   if (Kernel->getIterationSpace()->getOffsetXDecl()) {
     upper_x = createBinaryOperator(Ctx, upper_x,
         getOffsetXDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
   }
-  if (Kernel->getIterationSpace()->getOffsetYDecl()) {
+  if (!cpu_end_y && Kernel->getIterationSpace()->getOffsetYDecl()) {
     upper_y = createBinaryOperator(Ctx, upper_y,
         getOffsetYDecl(Kernel->getIterationSpace()), BO_Add, Ctx.IntTy);
   }
-  ForStmt *inner_loop = createForStmt(Ctx, gid_x_stmt, createBinaryOperator(Ctx,
-        tileVars.global_id_x, upper_x, BO_LT, Ctx.BoolTy),
-      createUnaryOperator(Ctx, tileVars.global_id_x, UO_PostInc,
-        tileVars.global_id_x->getType()), new_body);
-  ForStmt *outer_loop = createForStmt(Ctx, gid_y_stmt, createBinaryOperator(Ctx,
-        tileVars.global_id_y, upper_y, BO_LT, Ctx.BoolTy),
-      createUnaryOperator(Ctx, tileVars.global_id_y, UO_PostInc,
-        tileVars.global_id_y->getType()), inner_loop);
-
-  kernelBody.push_back(outer_loop);
+  Expr *inc_x = createUnaryOperator(Ctx, tileVars.global_id_x, UO_PostInc,
+      tileVars.global_id_x->getType());
+  Expr *inc_y = createUnaryOperator(Ctx, tileVars.global_id_y, UO_PostInc,
+      tileVars.global_id_y->getType());
+
+  // size of cache blocks; by default, the width of the blocks is chosen such
+  // that the rows of all windows of one block fit into half of the L2 cache
+  // and the blocks span all rows
+  int tile_size_x = 0, tile_size_y = 0;
+  if (compilerOptions.useCPUTile(USER_ON)) {
+    tile_size_x = compilerOptions.getCPUTileX();
+    tile_size_y = compilerOptions.getCPUTileY();
+  } else if (compilerOptions.useCPUTile(AUTO) &&
+             KernelClass->getKernelType() != UserOperator) {
+    HipaccImage *Img = Kernel->getIterationSpace()->getImage();
+    unsigned column_size = Img->getPixelSize();
+    unsigned window_size_y = 1;
+    for (auto img : KernelClass->getImgFields()) {
+      HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
+      column_size += Acc->getImage()->getPixelSize() * Acc->getSizeY();
+      window_size_y = std::max(window_size_y, Acc->getSizeY());
+    }
+    if (window_size_y > 1) {
+      tile_size_x = std::max(64u, Kernel->l2_cache_size/2/column_size/64*64);
+      if (tile_size_x >= static_cast<int>(Img->getSizeX()))
+        tile_size_x = 0;
+    }
+  }
+
+  //
+  // for (int tile_y=offset_y; tile_y<upper_y; tile_y+=tile_size_y) {
+  //     const int tile_end_y = min(tile_y+tile_size_y, upper_y);
+  //     for (int tile_x=offset_x; tile_x<upper_x; tile_x+=tile_size_x) {
+  //         const int tile_end_x = min(tile_x+tile_size_x, upper_x);
+  //         for (int gid_y=tile_y; gid_y<tile_end_y; gid_y++) {
+  //             int gid_x = tile_x;
+  //             column loops up to min(upper, tile_end_x)
+  //         }
+  //     }
+  // }
+  //
+  VarDecl *tile_x = nullptr, *tile_y = nullptr;
+  VarDecl *tile_end_x = nullptr, *tile_end_y = nullptr;
+  Expr *row_upper_y = upper_y;
+  auto createTileEnd = [&] (StringRef name, VarDecl *tile, int tile_size,
+      Expr *upper) -> VarDecl * {
+    Expr *end = createBinaryOperator(Ctx, createDeclRefExpr(Ctx, tile),
+        createIntegerLiteral(Ctx, tile_size), BO_Add, Ctx.IntTy);
+    return createVarDecl(Ctx, kernelDecl, name, Ctx.getConstType(Ctx.IntTy),
+        createConditionalOperator(Ctx, createBinaryOperator(Ctx, end, upper,
+            BO_LT, Ctx.BoolTy), end, upper, Ctx.IntTy));
+  };
+  if (tile_size_x) {
+    tile_x = createVarDecl(Ctx, kernelDecl, "tile_x", Ctx.IntTy, lower_x);
+    tile_end_x = createTileEnd("tile_end_x", tile_x, tile_size_x, upper_x);
+    gid_x->setInit(createDeclRefExpr(Ctx, tile_x));
+  }
+  if (tile_size_x && tile_size_y) {
+    tile_y = createVarDecl(Ctx, kernelDecl, "tile_y", Ctx.IntTy,
+        gid_y->getInit());
+    tile_end_y = createTileEnd("tile_end_y", tile_y, tile_size_y, upper_y);
+    gid_y->setInit(createDeclRefExpr(Ctx, tile_y));
+    row_upper_y = createDeclRefExpr(Ctx, tile_end_y);
+  }
+
+  // upper bound of a column loop within the current block
+  auto clampX = [&] (Expr *upper) -> Expr * {
+    if (!tile_end_x)
+      return upper;
+    if (upper == upper_x)
+      return createDeclRefExpr(Ctx, tile_end_x);
+    return createConditionalOperator(Ctx, createBinaryOperator(Ctx, upper,
+          createDeclRefExpr(Ctx, tile_end_x), BO_LT, Ctx.BoolTy), upper,
+        createDeclRefExpr(Ctx, tile_end_x), Ctx.IntTy);
+  };
+
+  auto createTileLoops = [&] (Stmt *rows) -> Stmt * {
+    if (!tile_x)
+      return rows;
+
+    auto createTileLoop = [&] (VarDecl *tile, VarDecl *tile_end, int
+        tile_size, Expr *upper, Stmt *body) -> Stmt * {
+      DeclRefExpr *tile_ref = createDeclRefExpr(Ctx, tile);
+      Stmt *tile_body[] = { createDeclStmt(Ctx, tile_end), body };
+      return createForStmt(Ctx, createDeclStmt(Ctx, tile),
+          createBinaryOperator(Ctx, tile_ref, upper, BO_LT, Ctx.BoolTy),
+          createCompoundAssignOperator(Ctx, tile_ref, createIntegerLiteral(Ctx,
+              tile_size), BO_AddAssign, Ctx.IntTy),
+          createCompoundStmt(Ctx, tile_body));
+    };
+
+    Stmt *loops = createTileLoop(tile_x, tile_end_x, tile_size_x, upper_x,
+        rows);
+    if (tile_y)
+      loops = createTileLoop(tile_y, tile_end_y, tile_size_y, upper_y, loops);
+    return loops;
+  };
+
+  //
+  // { body(gid_y) body(gid_y+1) ... body(gid_y+rows-1) }
+  // Rows computed by one iteration of the row loop (register blocking); the
+  // windows of vertically adjacent pixels overlap, so that the host compiler
+  // loads the shared input rows only once for all rows.
+  //
+  auto cloneRows = [&] (int rows) -> Stmt * {
+    SmallVector<Stmt *, 16> bodies;
+    for (int p=0; p<rows; ++p) {
+      // clear all stored decls before cloning, otherwise existing VarDecls
+      // will be reused and we will miss declarations
+      KernelDeclMap.clear();
+      gidYRef = p ? createBinaryOperator(Ctx, tileVars.global_id_y,
+          createIntegerLiteral(Ctx, p), BO_Add, Ctx.IntTy) :
+        tileVars.global_id_y;
+      bodies.push_back(Clone(S));
+    }
+    gidYRef = tileVars.global_id_y;
+    if (rows == 1)
+      return bodies.front();
+    return createCompoundStmt(Ctx, bodies);
+  };
+
+  //
+  // for (; gid_x+W<=upper; gid_x+=W) {
+  //     for (int simd_x=gid_x; simd_x<gid_x+W; simd_x++) body(simd_x)
+  // }
+  // The lane loop has a constant trip count of one SIMD register and no
+  // loop-carried dependencies. Together with the __restrict__ Accessors, this
+  // lets GCC and Clang map it onto SIMD registers without compiler-specific
+  // loop pragmas.
+  //
+  auto createSIMDLoop = [&] (Expr *upper, int rows) -> Stmt * {
+    VarDecl *simd_x = createVarDecl(Ctx, kernelDecl, "simd_x", Ctx.IntTy,
+        tileVars.global_id_x);
+    DeclRefExpr *simd_x_ref = createDeclRefExpr(Ctx, simd_x);
+    Expr *simd_upper = createBinaryOperator(Ctx, tileVars.global_id_x,
+        createIntegerLiteral(Ctx, simd_width), BO_Add, Ctx.IntTy);
+
+    // the body of the lane loop accesses pixels at simd_x
+    Expr *gid_x_ref = tileVars.global_id_x;
+    tileVars.global_id_x = simd_x_ref;
+    Stmt *lane_body = cloneRows(rows);
+    tileVars.global_id_x = gid_x_ref;
+
+    Stmt *lane_loop = createForStmt(Ctx, createDeclStmt(Ctx, simd_x),
+        createBinaryOperator(Ctx, simd_x_ref, simd_upper, BO_LT, Ctx.BoolTy),
+        createUnaryOperator(Ctx, simd_x_ref, UO_PostInc, Ctx.IntTy),
+        lane_body);
+
+    return createForStmt(Ctx, nullptr, createBinaryOperator(Ctx, simd_upper,
+          upper, BO_LE, Ctx.BoolTy), createCompoundAssignOperator(Ctx,
+            tileVars.global_id_x, createIntegerLiteral(Ctx, simd_width),
+            BO_AddAssign, Ctx.IntTy), createCompoundStmt(Ctx, lane_loop));
+  };
+
+  // separable convolutions: each row first computes the vertical pass into a
+  // line buffer, which is then read by the horizontal pass of the kernel body;
+  // median filters and sliding sums compute the results of the row the same
+  // way, sliding sums keep their column sums from the previous row
+  if (KernelClass->getKernelType() != UserOperator) {
+    findSeparableConvolutions(S,
+        Kernel->getIterationSpace()->getOffsetXDecl() ? lower_x : nullptr);
+    for (auto &conv : sepConvs)
+      kernelBody.push_back(createDeclStmt(Ctx, conv.buffer));
+    for (auto &filter : medianFilters) {
+      kernelBody.push_back(createDeclStmt(Ctx, filter.columns));
+      kernelBody.push_back(createDeclStmt(Ctx, filter.buffer));
+    }
+    for (auto &sum : slidingSums) {
+      kernelBody.push_back(createDeclStmt(Ctx, sum.columns));
+      kernelBody.push_back(createDeclStmt(Ctx, sum.buffer));
+    }
+  }
+
+  // number of rows computed per iteration of the row loop; the row passes
+  // already share the loads of vertically adjacent windows through their
+  // line buffers, and sliding sums step single rows
+  int ppt = Kernel->getPixelsPerThread();
+  if (!sepConvs.empty() || !medianFilters.empty() || !slidingSums.empty())
+    ppt = 1;
+
+  //
+  // for (int gid_y=offset_y; gid_y<upper; gid_y++) rows(1)
+  // or, computing ppt rows per iteration:
+  // int gid_y=offset_y;
+  // for (; gid_y+ppt<=upper; gid_y+=ppt) rows(ppt)
+  // for (; gid_y<upper; gid_y++) rows(1)
+  //
+  auto createRowLoops = [&] (std::function<Stmt *(int)> createRows) ->
+      Stmt * {
+    if (ppt <= 1)
+      return createForStmt(Ctx, gid_y_stmt, createBinaryOperator(Ctx,
+            tileVars.global_id_y, row_upper_y, BO_LT, Ctx.BoolTy), inc_y,
+          createRows(1));
+    Stmt *loops[] = {
+      gid_y_stmt,
+      createForStmt(Ctx, nullptr, createBinaryOperator(Ctx,
+            createBinaryOperator(Ctx, tileVars.global_id_y,
+              createIntegerLiteral(Ctx, ppt), BO_Add, Ctx.IntTy), row_upper_y,
+            BO_LE, Ctx.BoolTy), createCompoundAssignOperator(Ctx,
+              tileVars.global_id_y, createIntegerLiteral(Ctx, ppt),
+              BO_AddAssign, Ctx.IntTy), createRows(ppt)),
+      createForStmt(Ctx, nullptr, createBinaryOperator(Ctx,
+            tileVars.global_id_y, row_upper_y, BO_LT, Ctx.BoolTy), inc_y,
+          createRows(1))
+    };
+    return createCompoundStmt(Ctx, loops);
+  };
+
+  auto addRowPass = [&] (Stmt *row, bool split_x, bool top, bool bottom) ->
+      Stmt * {
+    if (sepConvs.empty() && medianFilters.empty() && slidingSums.empty())
+      return row;
+    Expr *start = tile_x ? createDeclRefExpr(Ctx, tile_x) : lower_x;
+    Stmt *stmts[] = { createSeparableRowPass(start, clampX(upper_x), lower_x,
+        upper_x, gid_y->getInit(), split_x, top, bottom), row };
+    return createCompoundStmt(Ctx, stmts);
+  };
+
+  if (!(kernel_x || kernel_y) || !split_regions) {
+    // no border handling, or border handling for all pixels
+    if (kernel_x) {
+      bh_variant.borders.left = 1;
+      bh_variant.borders.right = 1;
+    }
+    if (kernel_y) {
+      bh_variant.borders.top = 1;
+      bh_variant.borders.bottom = 1;
+    }
+
+    auto createRows = [&] (int rows) -> Stmt * {
+      // convert the function body to kernel syntax
+      Stmt *new_body = cloneRows(rows);
+
+      Stmt *inner_loop = nullptr;
+      if (simd_width > 1 && !kernel_x) {
+        // int gid_x = offset_x;
+        // SIMD loop, followed by the scalar loop for the remaining pixels
+        SmallVector<Stmt *, 16> rowBody;
+        rowBody.push_back(gid_x_stmt);
+        rowBody.push_back(createSIMDLoop(clampX(upper_x), rows));
+        rowBody.push_back(createForStmt(Ctx, nullptr, createBinaryOperator(Ctx,
+                tileVars.global_id_x, clampX(upper_x), BO_LT, Ctx.BoolTy),
+              inc_x, new_body));
+        inner_loop = createCompoundStmt(Ctx, rowBody);
+      } else {
+        inner_loop = createForStmt(Ctx, gid_x_stmt,
+            createBinaryOperator(Ctx, tileVars.global_id_x, clampX(upper_x),
+              BO_LT, Ctx.BoolTy), inc_x, new_body);
+      }
+      return addRowPass(inner_loop, false, kernel_y, kernel_y);
+    };
+
+    kernelBody.push_back(createTileLoops(createRowLoops(createRows)));
+    return;
+  }
+
+  //
+  // Split the iteration space into an interior region without boundary
+  // handling, four border strips, and four corners, each checking only the
+  // borders it may exceed. The row selects the vertical region, the column
+  // loops continue where the previous region stopped:
+  //
+  // for (int gid_y=offset_y; gid_y<is_height+offset_y; gid_y++) {
+  //     int gid_x = offset_x;
+  //     if (is_width < 2*bh_x || is_height < 2*bh_y) {
+  //         for (; gid_x<is_width+offset_x; gid_x++) body_all_borders
+  //     } else if (gid_y < offset_y+bh_y) {
+  //         for (; gid_x<offset_x+bh_x; gid_x++) body_top_left
+  //         for (; gid_x<is_width+offset_x-bh_x; gid_x++) body_top
+  //         for (; gid_x<is_width+offset_x; gid_x++) body_top_right
+  //     } else if (gid_y >= is_height+offset_y-bh_y) {
+  //         ... bottom left, bottom, bottom right
+  //     } else {
+  //         ... left, interior, right
+  //     }
+  // }
+  //
+  Expr *bh_x = createIntegerLiteral(Ctx,
+      static_cast<int32_t>(Kernel->getMaxSizeX()));
+  Expr *bh_y = createIntegerLiteral(Ctx,
+      static_cast<int32_t>(Kernel->getMaxSizeY()));
+  Expr *lower_y = createIntegerLiteral(Ctx, 0);
+  Expr *is_height = getHeightDecl(Kernel->getIterationSpace());
+  Expr *is_upper_y = is_height;
+  if (Kernel->getIterationSpace()->getOffsetYDecl()) {
+    lower_y = getOffsetYDecl(Kernel->getIterationSpace());
+    is_upper_y = createBinaryOperator(Ctx, is_height, lower_y, BO_Add,
+        Ctx.IntTy);
+  }
+
+  // for (; gid_x<upper; gid_x++) body
+  // regions without boundary handling in x start with a SIMD loop
+  auto createRegionLoop = [&] (Expr *upper, bool top, bool bottom, bool left,
+      bool right, int rows) -> Stmt * {
+    bh_variant.borders.top = top;
+    bh_variant.borders.bottom = bottom;
+    bh_variant.borders.left = left;
+    bh_variant.borders.right = right;
+
+    // pixels without boundary handling in x read sliding windows, unless the
+    // pixels are computed by SIMD lanes
+    rotateWindows = compilerOptions.rotateWindows() && simd_width == 1 &&
+      !left && !right;
+    Stmt *new_body = cloneRows(rows);
+    rotateWindows = false;
+
+    upper = clampX(upper);
+    Stmt *loop = createWindowLoop(upper, inc_x, new_body);
+    if (simd_width > 1 && !left && !right) {
+      Stmt *loops[] = { createSIMDLoop(upper, rows), loop };
+      loop = createCompoundStmt(Ctx, loops);
+    }
+
+    // reset image border configuration
+    bh_variant.borderVal = 0;
+
+    return loop;
+  };
+
+  // left, center, and right region of a row
+  auto createRegionRow = [&] (bool top, bool bottom, int rows) -> Stmt * {
+    SmallVector<Stmt *, 16> rowBody;
+    if (kernel_x) {
+      rowBody.push_back(createRegionLoop(createBinaryOperator(Ctx, lower_x,
+              bh_x, BO_Add, Ctx.IntTy), top, bottom, true, false, rows));
+      rowBody.push_back(createRegionLoop(createBinaryOperator(Ctx, upper_x,
+              bh_x, BO_Sub, Ctx.IntTy), top, bottom, false, false, rows));
+      rowBody.push_back(createRegionLoop(upper_x, top, bottom, false, true,
+            rows));
+    } else {
+      rowBody.push_back(createRegionLoop(upper_x, top, bottom, false, false,
+            rows));
+    }
+    return addRowPass(createCompoundStmt(Ctx, rowBody), true, top, bottom);
+  };
+
+  // fall back: in case the image is too small, use code variant with boundary
+  // handling for all borders; blocks of rows must not reach into the top and
+  // the bottom border at the same time
+  Expr *fall_back = nullptr;
+  if (kernel_x) {
+    fall_back = createBinaryOperator(Ctx,
+        getWidthDecl(Kernel->getIterationSpace()), createBinaryOperator(Ctx,
+          createIntegerLiteral(Ctx, 2), bh_x, BO_Mul, Ctx.IntTy), BO_LT,
+        Ctx.BoolTy);
+  }
+  if (kernel_y) {
+    Expr *min_height = createBinaryOperator(Ctx, createIntegerLiteral(Ctx, 2),
+        bh_y, BO_Mul, Ctx.IntTy);
+    if (ppt > 1)
+      min_height = createBinaryOperator(Ctx, min_height,
+          createIntegerLiteral(Ctx, ppt-1), BO_Add, Ctx.IntTy);
+    Expr *fall_back_y = createBinaryOperator(Ctx, is_height, min_height,
+        BO_LT, Ctx.BoolTy);
+    fall_back = fall_back ? createBinaryOperator(Ctx, fall_back, fall_back_y,
+        BO_LOr, Ctx.BoolTy) : fall_back_y;
+  }
+
+  // a block of rows is in the top region if its first row is, and in the
+  // bottom region if its last row is
+  auto createRows = [&] (int rows) -> Stmt * {
+    Stmt *regions = createRegionRow(false, false, rows);
+    if (kernel_y) {
+      Expr *last_y = tileVars.global_id_y;
+      if (rows > 1)
+        last_y = createBinaryOperator(Ctx, last_y, createIntegerLiteral(Ctx,
+              rows-1), BO_Add, Ctx.IntTy);
+      regions = createIfStmt(Ctx, createBinaryOperator(Ctx,
+            tileVars.global_id_y, createBinaryOperator(Ctx, lower_y, bh_y,
+              BO_Add, Ctx.IntTy), BO_LT, Ctx.BoolTy), createRegionRow(true,
+              false, rows), createIfStmt(Ctx, createBinaryOperator(Ctx, last_y,
+                createBinaryOperator(Ctx, is_upper_y, bh_y, BO_Sub,
+                  Ctx.IntTy), BO_GE, Ctx.BoolTy), createRegionRow(false, true,
+                  rows), regions));
+    }
+    Stmt *fall_back_loop = createRegionLoop(upper_x, kernel_y, kernel_y,
+        kernel_x, kernel_x, rows);
+    regions = createIfStmt(Ctx, fall_back, addRowPass(createCompoundStmt(Ctx,
+            fall_back_loop), false, kernel_y, kernel_y), regions);
+
+    SmallVector<Stmt *, 16> rowBody;
+    rowBody.push_back(gid_x_stmt);
+    rowBody.push_back(regions);
+    return createCompoundStmt(Ctx, rowBody);
+  };
+
+  kernelBody.push_back(createTileLoops(createRowLoops(createRows)));
 }
 
 
@@ -592,6 +995,16 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
       continue;
     }
 
+    // search for row band parameters of multithreaded CPU kernels
+    if (param->getName().equals("cpu_start_y")) {
+      cpu_start_y = parm_ref;
+      continue;
+    }
+    if (param->getName().equals("cpu_end_y")) {
+      cpu_end_y = parm_ref;
+      continue;
+    }
+
     if (compilerOptions.emitRenderscript() ||
         compilerOptions.emitFilterscript()) {
       // search for uint32_t x, uint32_t y parameters
@@ -633,6 +1046,36 @@ Stmt *ASTTranslate::Hipacc(Stmt *S) {
     }
   }
 
+  // search for image width, height and stride parameters of fused producer
+  // kernels, prefixed by the name of the Accessor they replace
+  for (auto &fusion : Kernel->getFusedKernels()) {
+    std::string prefix = fusion.field->getNameAsString() + "_";
+    HipaccKernelClass *KC = fusion.kernel->getKernelClass();
+    for (auto param : kernelDecl->parameters()) {
+      for (auto img : KC->getImgFields()) {
+        if (img == KC->getOutField())
+          continue;
+        HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
+        std::string name = prefix + img->getNameAsString();
+
+        if (param->getName().equals(name + "_width"))
+          Acc->setWidthDecl(createDeclRefExpr(Ctx, param));
+        if (param->getName().equals(name + "_height"))
+          Acc->setHeightDecl(createDeclRefExpr(Ctx, param));
+        if (param->getName().equals(name + "_stride"))
+          Acc->setStrideDecl(createDeclRefExpr(Ctx, param));
+      }
+    }
+    for (auto img : KC->getImgFields()) {
+      if (img == KC->getOutField())
+        continue;
+      HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
+
+      if (Acc->getStrideDecl() == nullptr)
+        Acc->setStrideDecl(Acc->getWidthDecl());
+    }
+  }
+
   // in case no stride was found, use image width as fallback
   for (auto img : KernelClass->getImgFields()) {
     HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
@@ -1686,9 +2129,10 @@ Expr *ASTTranslate::VisitMemberExprTranslate(MemberExpr *E) {
   ValueDecl *paramDecl = nullptr;
 
   // search for member name in kernel parameter list
+  std::string name = fusedPrefix + VD->getNameAsString();
   for (auto param : kernelDecl->parameters()) {
     // parameter name matches
-    if (param->getName().equals(VD->getName())) {
+    if (param->getName().equals(name)) {
       paramDecl = param;
 
       // get vector declaration
@@ -1738,10 +2182,10 @@ Expr *ASTTranslate::VisitMemberExprTranslate(MemberExpr *E) {
     }
   }
 
-  if (!isMask) {
-      // mark parameter as being used within the kernel unless for Masks and
-      // Domains
-      Kernel->setUsed(VD->getName());
+  if (!isMask && !Kernel->getFusedKernel(dyn_cast<FieldDecl>(VD))) {
+      // mark parameter as being used within the kernel unless for Masks,
+      // Domains, and Accessors computed by fused producer kernels
+      Kernel->setUsed(name);
   }
 
   Expr *result = createDeclRefExpr(Ctx, paramDecl);
@@ -2275,6 +2719,13 @@ Expr *ASTTranslate::VisitCXXMemberCallExprTranslate(CXXMemberCallExpr *E) {
       assert(E->getNumArgs()==0 && "no arguments for output() method supported!");
       Expr *result = nullptr;
 
+      // inlined producer kernel: write to the temporary of the fused pixel
+      if (fusedOutput) {
+        result = createDeclRefExpr(Ctx, fusedOutput);
+        setExprProps(E, result);
+        return result;
+      }
+
       switch (compilerOptions.getTargetLang()) {
         case Language::Renderscript:
           if (Kernel->getPixelsPerThread() <= 1) {
@@ -30,8 +30,12 @@
 //===----------------------------------------------------------------------===//
 
 // includes for numeric_limits
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
+#include <llvm/Support/MathExtras.h>
+
 #include "hipacc/AST/ASTTranslate.h"
 
 using namespace clang;
@@ -79,8 +83,17 @@ Stmt *ASTTranslate::getConvolutionStmt(Reduce mode, DeclRefExpr *tmp_var,
       result = createCompoundAssignOperator(Ctx, tmp_var, ret_val, BO_MulAssign,
           tmp_var->getType());
       break;
-    case Reduce::MEDIAN:
-      assert(0 && "Unsupported reduction mode.");
+    case Reduce::MEDIAN: {
+      // val<i> = val;
+      auto median = std::find_if(medians.rbegin(), medians.rend(),
+          [&] (const MedianSelection &median) {
+            return median.tmp->getDecl() == tmp_var->getDecl();
+          });
+      assert(median != medians.rend() && "median selection not found");
+      DeclRefExpr *value = median->values.back();
+      result = createBinaryOperator(Ctx, value, ret_val, BO_Assign,
+          value->getType());
+      break; }
   }
 
   return result;
@@ -93,7 +106,7 @@ template<typename T> T get_init(Reduce mode) {
     case Reduce::MIN:    return std::numeric_limits<T>::max();
     case Reduce::MAX:    return std::numeric_limits<T>::min();
     case Reduce::PROD:   return 1;
-    case Reduce::MEDIAN: assert(false && "Median not yet supported");
+    case Reduce::MEDIAN: assert(false && "Median has no initial value");
     default:             assert(false && "Unsupported reduction mode");
   }
 }
@@ -233,6 +246,778 @@ Stmt *ASTTranslate::addDomainCheck(HipaccMask *Domain, DeclRefExpr *domain_var,
 }
 
 
+// expression returned by a lambda-function consisting of a single return
+// statement
+static Expr *getReturnValue(LambdaExpr *LE) {
+  CompoundStmt *body = dyn_cast<CompoundStmt>(LE->getBody());
+  if (!body || body->size() != 1)
+    return nullptr;
+  ReturnStmt *ret = dyn_cast<ReturnStmt>(body->body_front());
+  return ret ? ret->getRetValue() : nullptr;
+}
+
+
+// check if the expression reads an Accessor at the current offset of the
+// Mask, i.e. 'acc(mask)' or 'convert_<type>(acc(mask))', and return the field
+// of the Accessor
+static FieldDecl *getMaskRead(Expr *E, FieldDecl *FD) {
+  CallExpr *convert = dyn_cast<CallExpr>(E->IgnoreParenImpCasts());
+  if (convert && !isa<CXXOperatorCallExpr>(convert) &&
+      convert->getNumArgs() == 1 && convert->getDirectCallee() &&
+      convert->getDirectCallee()->getName().startswith("convert_"))
+    E = convert->getArg(0);
+  CXXOperatorCallExpr *read = dyn_cast<CXXOperatorCallExpr>(
+      E->IgnoreParenImpCasts());
+  if (!read || read->getNumArgs() != 2)
+    return nullptr;
+  MemberExpr *acc = dyn_cast<MemberExpr>(read->getArg(0));
+  MemberExpr *mask = dyn_cast<MemberExpr>(read->getArg(1)->IgnoreImpCasts());
+  if (!acc || !mask || mask->getMemberDecl() != FD)
+    return nullptr;
+  return dyn_cast<FieldDecl>(acc->getMemberDecl());
+}
+
+
+// check if the lambda-function returns the product of the current Mask
+// coefficient and another expression, i.e. 'return mask() * expr;'
+static BinaryOperator *getWeightedExpr(LambdaExpr *LE, FieldDecl *FD, Expr
+    *&weighted) {
+  Expr *ret_val = getReturnValue(LE);
+  if (!ret_val)
+    return nullptr;
+  BinaryOperator *mul = dyn_cast<BinaryOperator>(ret_val->IgnoreParenImpCasts());
+  if (!mul || mul->getOpcode() != BO_Mul)
+    return nullptr;
+
+  auto isCoefficient = [&] (Expr *E) -> bool {
+    CXXOperatorCallExpr *call = dyn_cast<CXXOperatorCallExpr>(
+        E->IgnoreParenImpCasts());
+    if (!call || call->getNumArgs() != 1)
+      return false;
+    MemberExpr *ME = dyn_cast<MemberExpr>(call->getArg(0)->IgnoreParenImpCasts());
+    return ME && ME->getMemberDecl() == FD;
+  };
+
+  if (isCoefficient(mul->getLHS())) {
+    weighted = mul->getRHS();
+    return mul;
+  }
+  if (isCoefficient(mul->getRHS())) {
+    weighted = mul->getLHS();
+    return mul;
+  }
+  return nullptr;
+}
+
+
+// Unroll a sum convolution over a constant Mask for C/C++: coefficients that
+// are zero are dropped, taps sharing a coefficient are added up before the
+// multiplication, and powers of two are applied as shifts for unsigned data
+bool ASTTranslate::convertConstantConvolution(HipaccMask *Mask, FieldDecl *FD,
+    LambdaExpr *LE, CompoundStmt *outerCompountStmt) {
+  Expr *weighted = nullptr;
+  BinaryOperator *mul = getWeightedExpr(LE, FD, weighted);
+  if (!mul)
+    return false;
+
+  struct Tap { size_t x, y; };
+  struct Coefficient {
+    APValue value;
+    Expr *init;
+    SmallVector<Tap, 16> taps;
+  };
+  SmallVector<Coefficient, 16> coefficients;
+
+  auto isEqual = [] (const APValue &lhs, const APValue &rhs) -> bool {
+    if (lhs.isInt() && rhs.isInt())
+      return llvm::APSInt::isSameValue(lhs.getInt(), rhs.getInt());
+    if (lhs.isFloat() && rhs.isFloat())
+      return lhs.getFloat().bitwiseIsEqual(rhs.getFloat());
+    return false;
+  };
+
+  // group taps by coefficient, in order of their first occurrence
+  for (size_t y=0; y<Mask->getSizeY(); ++y) {
+    for (size_t x=0; x<Mask->getSizeX(); ++x) {
+      Expr *init = Mask->getInitExpr(x, y);
+      Expr::EvalResult result;
+      if (!init->EvaluateAsRValue(result, Ctx) ||
+          !(result.Val.isInt() || result.Val.isFloat()))
+        return false;
+      if ((result.Val.isInt() && !result.Val.getInt()) ||
+          (result.Val.isFloat() && result.Val.getFloat().isZero()))
+        continue;
+
+      auto it = std::find_if(coefficients.begin(), coefficients.end(),
+          [&] (const Coefficient &c) { return isEqual(c.value, result.Val); });
+      if (it == coefficients.end()) {
+        coefficients.push_back({ result.Val, init, {} });
+        it = coefficients.end() - 1;
+      }
+      it->taps.push_back({ x, y });
+    }
+  }
+
+  bool unsigned_data = weighted->IgnoreImpCasts()->getType()->
+    isUnsignedIntegerType();
+  for (auto &coefficient : coefficients) {
+    // _tmp += (expr(x0, y0) + expr(x1, y1) + ...) * coefficient;
+    Expr *sum = nullptr;
+    for (auto tap : coefficient.taps) {
+      convIdxX = tap.x;
+      convIdxY = tap.y;
+      Expr *term = Clone(weighted);
+      sum = sum ? createBinaryOperator(Ctx, sum, term, BO_Add,
+          weighted->getType()) : term;
+      // clear decls added while cloning last iteration
+      LambdaDeclMap.clear();
+    }
+    if (coefficient.taps.size() > 1)
+      sum = createParenExpr(Ctx, sum);
+
+    const APValue &value = coefficient.value;
+    Expr *result = nullptr;
+    if (value.isInt() && value.getInt() == 1) {
+      result = sum;
+    } else if (value.isFloat() && value.getFloat().isExactlyValue(1.0)) {
+      result = sum;
+    } else if (value.isInt() && value.getInt().isStrictlyPositive() &&
+               value.getInt().isPowerOf2() && unsigned_data &&
+               mul->getType()->isIntegerType()) {
+      result = createBinaryOperator(Ctx, sum, createIntegerLiteral(Ctx,
+            static_cast<int32_t>(value.getInt().logBase2())), BO_Shl,
+          mul->getType());
+    } else {
+      result = createBinaryOperator(Ctx, sum, Clone(coefficient.init), BO_Mul,
+          mul->getType());
+    }
+
+    preStmts.push_back(getConvolutionStmt(Reduce::SUM, convTmp, result));
+    preCStmt.push_back(outerCompountStmt);
+  }
+
+  return true;
+}
+
+
+// factorize the coefficients of a constant Mask into weights for columns and
+// rows, mask(x, y) = weights_y[y] * weights_x[x]
+static bool factorizeMask(ASTContext &Ctx, HipaccMask *Mask,
+    SmallVectorImpl<double> &weights_x, SmallVectorImpl<double> &weights_y) {
+  size_t size_x = Mask->getSizeX(), size_y = Mask->getSizeY();
+  bool is_int = Mask->getType()->isIntegerType();
+  SmallVector<double, 64> coefficients;
+
+  for (size_t y=0; y<size_y; ++y) {
+    for (size_t x=0; x<size_x; ++x) {
+      Expr::EvalResult result;
+      if (!Mask->getInitExpr(x, y)->EvaluateAsRValue(result, Ctx))
+        return false;
+      if (result.Val.isInt()) {
+        coefficients.push_back(result.Val.getInt().getSExtValue());
+      } else if (result.Val.isFloat()) {
+        llvm::APFloat value(result.Val.getFloat());
+        bool loses_info;
+        value.convert(llvm::APFloat::IEEEdouble(),
+            llvm::APFloat::rmNearestTiesToEven, &loses_info);
+        coefficients.push_back(value.convertToDouble());
+      } else {
+        return false;
+      }
+    }
+  }
+  auto M = [&] (size_t x, size_t y) { return coefficients[y*size_x + x]; };
+
+  // pivot: coefficient with the largest magnitude
+  size_t px = 0, py = 0;
+  for (size_t y=0; y<size_y; ++y)
+    for (size_t x=0; x<size_x; ++x)
+      if (std::fabs(M(x, y)) > std::fabs(M(px, py))) {
+        px = x;
+        py = y;
+      }
+  if (M(px, py) == 0)
+    return false;
+
+  // integer weights: divide the pivot row by the gcd of its coefficients
+  uint64_t gcd = 1;
+  if (is_int) {
+    gcd = 0;
+    for (size_t x=0; x<size_x; ++x)
+      gcd = llvm::GreatestCommonDivisor64(gcd,
+          static_cast<uint64_t>(std::fabs(M(x, py))));
+  }
+  weights_x.clear();
+  weights_y.clear();
+  for (size_t x=0; x<size_x; ++x)
+    weights_x.push_back(M(x, py) / gcd);
+  for (size_t y=0; y<size_y; ++y) {
+    if (is_int && std::fmod(M(px, y), weights_x[px]) != 0)
+      return false;
+    weights_y.push_back(M(px, y) / weights_x[px]);
+  }
+
+  // check if the Mask has rank 1
+  double epsilon = is_int ? 0 : 1e-6 * std::fabs(M(px, py));
+  for (size_t y=0; y<size_y; ++y)
+    for (size_t x=0; x<size_x; ++x)
+      if (std::fabs(M(x, y) - weights_y[y]*weights_x[x]) > epsilon)
+        return false;
+
+  return true;
+}
+
+
+// check if all coefficients of a constant Mask are equal and not zero; weight
+// is set to the coefficient, or to nullptr if the coefficient is one
+static bool hasEqualCoefficients(ASTContext &Ctx, HipaccMask *Mask, Expr
+    *&weight) {
+  Expr::EvalResult first;
+  if (!Mask->getInitExpr(0, 0)->EvaluateAsRValue(first, Ctx))
+    return false;
+  if (first.Val.isInt()) {
+    if (!first.Val.getInt())
+      return false;
+  } else if (first.Val.isFloat()) {
+    if (first.Val.getFloat().isZero())
+      return false;
+  } else {
+    return false;
+  }
+
+  for (size_t y=0; y<Mask->getSizeY(); ++y) {
+    for (size_t x=0; x<Mask->getSizeX(); ++x) {
+      Expr::EvalResult result;
+      if (!Mask->getInitExpr(x, y)->EvaluateAsRValue(result, Ctx))
+        return false;
+      if (result.Val.isInt() && first.Val.isInt()) {
+        if (!llvm::APSInt::isSameValue(result.Val.getInt(),
+              first.Val.getInt()))
+          return false;
+      } else if (result.Val.isFloat() && first.Val.isFloat()) {
+        if (!result.Val.getFloat().bitwiseIsEqual(first.Val.getFloat()))
+          return false;
+      } else {
+        return false;
+      }
+    }
+  }
+
+  bool one = first.Val.isInt() ? first.Val.getInt() == 1 :
+    first.Val.getFloat().isExactlyValue(1.0);
+  weight = one ? nullptr : Mask->getInitExpr(0, 0);
+  return true;
+}
+
+
+// create literal for a weight of a separable Mask
+static Expr *createWeight(ASTContext &Ctx, double weight, QualType QT) {
+  if (QT->isIntegerType())
+    return createIntegerLiteral(Ctx, static_cast<int32_t>(weight));
+  if (QT->isSpecificBuiltinType(BuiltinType::Float))
+    return FloatingLiteral::Create(Ctx, llvm::APFloat(static_cast<float>(
+            weight)), false, Ctx.FloatTy, SourceLocation());
+  return FloatingLiteral::Create(Ctx, llvm::APFloat(weight), false,
+      Ctx.DoubleTy, SourceLocation());
+}
+
+
+// weight * expr, omitting weights of one
+static Expr *createWeightedExpr(ASTContext &Ctx, double weight, QualType
+    MaskQT, Expr *E, QualType QT) {
+  if (weight == 1)
+    return E;
+  return createBinaryOperator(Ctx, createWeight(Ctx, weight, MaskQT), E,
+      BO_Mul, QT);
+}
+
+
+// find sum convolutions over separable constant Masks in the kernel body;
+// Masks need more than one row and column. Integer sums with equal
+// coefficients, over constant Masks or rectangular Domains, become sliding sums
+// instead; floating-point sums are not slid, since adding and subtracting
+// values accumulates rounding errors along the rows of a band. Also
+// find median filters of 8-bit data over Masks of at least 7x7 pixels, for
+// which a sliding histogram is cheaper than a sorting network.
+void ASTTranslate::findSeparableConvolutions(Stmt *S, Expr *lower_x) {
+  sepConvs.clear();
+  medianFilters.clear();
+  slidingSums.clear();
+
+  HipaccImage *Img = Kernel->getIterationSpace()->getImage();
+  if (!Img->getSizeX())
+    return;
+
+  std::function<void(Stmt *)> findConvolutions = [&] (Stmt *S) {
+    if (!S)
+      return;
+    for (auto child : S->children())
+      findConvolutions(child);
+
+    CXXMemberCallExpr *E = dyn_cast<CXXMemberCallExpr>(S);
+    if (!E || !E->getDirectCallee() || E->getNumArgs() != 3)
+      return;
+    bool convolve = E->getDirectCallee()->getName().equals("convolve");
+    if (!convolve && !E->getDirectCallee()->getName().equals("reduce"))
+      return;
+
+    MemberExpr *ME = dyn_cast<MemberExpr>(E->getArg(0)->IgnoreImpCasts());
+    FieldDecl *FD = ME ? dyn_cast<FieldDecl>(ME->getMemberDecl()) : nullptr;
+    HipaccMask *Mask = FD ? Kernel->getMaskFromMapping(FD) : nullptr;
+    if (!Mask || Mask->isDomain() == convolve || Mask->getSizeX() < 2 ||
+        Mask->getSizeY() < 2)
+      return;
+
+    // line buffers hold the columns [start-size_x/2, end+size_x/2) of a row,
+    // which are size_x/2 more on each side also for Masks of even width
+    size_t line_x = Img->getSizeX() + 2*(Mask->getSizeX()/2);
+
+    llvm::APSInt mode;
+    MaterializeTemporaryExpr *MTE =
+      dyn_cast<MaterializeTemporaryExpr>(E->getArg(2));
+    LambdaExpr *LE = MTE ? dyn_cast<LambdaExpr>(
+        MTE->GetTemporaryExpr()->IgnoreImpCasts()) : nullptr;
+    if (!LE || !E->getArg(1)->EvaluateAsInt(mode, Ctx))
+      return;
+
+    // the Accessor has to be read at the Mask offsets
+    auto isMaskRead = [&] (Expr *read) -> bool {
+      FieldDecl *AccFD = read ? getMaskRead(read, FD) : nullptr;
+      HipaccAccessor *Acc = AccFD ? Kernel->getImgFromMapping(AccFD) : nullptr;
+      return Acc && Acc->getInterpolationMode() == Interpolate::NO;
+    };
+
+    // convolve(mask, Reduce::MEDIAN, [&] () { return acc(mask); });
+    if (convolve &&
+        static_cast<Reduce>(mode.getZExtValue()) == Reduce::MEDIAN) {
+      Expr *read = getReturnValue(LE);
+      size_t size_x = Mask->getSizeX(), size_y = Mask->getSizeY();
+      if (size_x*size_y < 49 || !isMaskRead(read) ||
+          !LE->getCallOperator()->getReturnType()->isSpecificBuiltinType(
+            BuiltinType::UChar) ||
+          !read->getType()->isSpecificBuiltinType(BuiltinType::UChar))
+        return;
+
+      // uchar _medcol<0>[(width+2*(size_x/2))*size_y], _med<0>[width];
+      MedianFilter filter;
+      filter.call = E;
+      filter.mask = Mask;
+      filter.read = read;
+      filter.lower_x = lower_x;
+      std::string id(std::to_string(literalCount++));
+      filter.columns = createVarDecl(Ctx, kernelDecl, "_medcol" + id,
+          Ctx.getConstantArrayType(Ctx.UnsignedCharTy, llvm::APInt(32,
+              line_x * size_y), ArrayType::Normal, 0));
+      filter.buffer = createVarDecl(Ctx, kernelDecl, "_med" + id,
+          Ctx.getConstantArrayType(Ctx.UnsignedCharTy, llvm::APInt(32,
+              Img->getSizeX()), ArrayType::Normal, 0));
+      FunctionDecl::castToDeclContext(kernelDecl)->addDecl(filter.columns);
+      FunctionDecl::castToDeclContext(kernelDecl)->addDecl(filter.buffer);
+      medianFilters.push_back(filter);
+      return;
+    }
+
+    if (static_cast<Reduce>(mode.getZExtValue()) != Reduce::SUM ||
+        !Mask->isConstant())
+      return;
+
+    // convolve(mask, Reduce::SUM, [&] () { return mask() * acc(mask); });
+    // reduce(dom, Reduce::SUM, [&] () { return acc(dom); });
+    Expr *read = nullptr, *weight = nullptr;
+    QualType type;
+    bool sliding = true;
+    if (convolve) {
+      BinaryOperator *mul = getWeightedExpr(LE, FD, read);
+      if (!mul)
+        return;
+      type = mul->getType();
+      sliding = type->isIntegerType() &&
+        hasEqualCoefficients(Ctx, Mask, weight);
+    } else {
+      read = getReturnValue(LE);
+      type = LE->getCallOperator()->getReturnType();
+      if (!type->isIntegerType())
+        return;
+      for (size_t y=0; y<Mask->getSizeY(); ++y)
+        for (size_t x=0; x<Mask->getSizeX(); ++x)
+          if (!Mask->isDomainDefined(x, y))
+            return;
+    }
+    if (!isMaskRead(read))
+      return;
+
+    if (sliding) {
+      // <type> _col<0>[width+2*(size_x/2)], _box<0>[width];
+      SlidingSum sum;
+      sum.call = E;
+      sum.mask = Mask;
+      sum.read = read;
+      sum.weight = weight;
+      sum.type = type;
+      sum.lower_x = lower_x;
+      std::string id(std::to_string(literalCount++));
+      sum.columns = createVarDecl(Ctx, kernelDecl, "_col" + id,
+          Ctx.getConstantArrayType(type, llvm::APInt(32, line_x),
+            ArrayType::Normal, 0));
+      sum.buffer = createVarDecl(Ctx, kernelDecl, "_box" + id,
+          Ctx.getConstantArrayType(type, llvm::APInt(32, Img->getSizeX()),
+            ArrayType::Normal, 0));
+      FunctionDecl::castToDeclContext(kernelDecl)->addDecl(sum.columns);
+      FunctionDecl::castToDeclContext(kernelDecl)->addDecl(sum.buffer);
+      slidingSums.push_back(sum);
+      return;
+    }
+
+    SeparableConvolution conv;
+    if (!factorizeMask(Ctx, Mask, conv.weights_x, conv.weights_y))
+      return;
+
+    // <type> _sep<0>[width+2*(size_x/2)];
+    conv.call = E;
+    conv.mask = Mask;
+    conv.weighted = read;
+    conv.type = type;
+    conv.lower_x = lower_x;
+    std::string buffer_name("_sep" + std::to_string(literalCount++));
+    conv.buffer = createVarDecl(Ctx, kernelDecl, buffer_name,
+        Ctx.getConstantArrayType(conv.type, llvm::APInt(32, line_x),
+          ArrayType::Normal, 0));
+    FunctionDecl::castToDeclContext(kernelDecl)->addDecl(conv.buffer);
+    sepConvs.push_back(conv);
+  };
+
+  findConvolutions(S);
+}
+
+
+//
+// compute the vertical pass of all separable convolutions for the pixels
+// [start-size_x/2, end+size_x/2) of the current row:
+//
+// {
+//     int sep_x = start-size_x/2;
+//     for (; sep_x<lower; sep_x++) _sep<0>[...] = sum_y w_y * acc(sep_x, y)
+//     for (; sep_x<min(end+size_x/2, upper); sep_x++) ...
+//     for (; sep_x<end+size_x/2; sep_x++) ...
+// }
+//
+// The first and last loop use boundary handling for the left and right
+// border, the second one only if split_x is false. Median filters store the
+// columns of the window the same way and filter the row afterwards:
+//
+//     hipaccMedianRow(_medcol<0>, size_x, size_y, start, end-start, _med<0>);
+//
+// Sliding sums compute the column sums only in the first row first_y of the
+// band; later rows add the row entering and subtract the row leaving the
+// window, then the window sums of the row are computed by a sliding window:
+//
+//     if (gid_y == first_y) { ... _col<0>[...] = sum_y acc(sep_x, y) }
+//     else { ... _col<0>[...] += acc(sep_x, size_y-1) - acc(sep_x, -1) }
+//     hipaccSlidingSumRow(_col<0>, size_x, start, end-start, _box<0>);
+//
+Stmt *ASTTranslate::createSeparableRowPass(Expr *start, Expr *end, Expr
+    *lower, Expr *upper, Expr *first_y, bool split_x, bool top, bool bottom) {
+  SmallVector<Stmt *, 16> body;
+
+  // loops over the columns sep_x of the Mask; column adds the statements for
+  // column sep_x, which is stored at index idx of the line buffer
+  auto createColumnLoops = [&] (HipaccMask *Mask, Expr *lower_x,
+      std::function<void(Expr *, SmallVectorImpl<Stmt *> &)> column) ->
+      Stmt * {
+    int half_x = static_cast<int>(Mask->getSizeX()/2);
+    Expr *first_x = createBinaryOperator(Ctx, start, createIntegerLiteral(Ctx,
+          half_x), BO_Sub, Ctx.IntTy);
+    Expr *last_x = createBinaryOperator(Ctx, end, createIntegerLiteral(Ctx,
+          half_x), BO_Add, Ctx.IntTy);
+
+    VarDecl *sep_x = createVarDecl(Ctx, kernelDecl, "sep_x", Ctx.IntTy,
+        first_x);
+    DeclRefExpr *sep_x_ref = createDeclRefExpr(Ctx, sep_x);
+    Expr *idx = createBinaryOperator(Ctx, sep_x_ref, createIntegerLiteral(Ctx,
+          half_x), BO_Add, Ctx.IntTy);
+    if (lower_x)
+      idx = createBinaryOperator(Ctx, createBinaryOperator(Ctx, sep_x_ref,
+            lower_x, BO_Sub, Ctx.IntTy), createIntegerLiteral(Ctx, half_x),
+          BO_Add, Ctx.IntTy);
+
+    auto createLoop = [&] (Expr *bound, bool left, bool right) -> Stmt * {
+      bh_variant.borders.top = top;
+      bh_variant.borders.bottom = bottom;
+      bh_variant.borders.left = left;
+      bh_variant.borders.right = right;
+
+      // read the Accessor at sep_x
+      Expr *gid_x_ref = tileVars.global_id_x;
+      HipaccMask *mask = convMask;
+      tileVars.global_id_x = sep_x_ref;
+      convMask = Mask;
+      convIdxX = half_x;
+
+      size_t num_stmts = preStmts.size();
+      SmallVector<Stmt *, 16> stmts;
+      column(idx, stmts);
+
+      tileVars.global_id_x = gid_x_ref;
+      convMask = mask;
+      convIdxX = convIdxY = 0;
+      bh_variant.borderVal = 0;
+
+      // temporaries for boundary handling precede the assignments
+      SmallVector<Stmt *, 16> loop_body(preStmts.begin() + num_stmts,
+          preStmts.end());
+      preStmts.resize(num_stmts);
+      preCStmt.resize(num_stmts);
+      loop_body.append(stmts.begin(), stmts.end());
+
+      return createForStmt(Ctx, nullptr, createBinaryOperator(Ctx, sep_x_ref,
+            bound, BO_LT, Ctx.BoolTy), createUnaryOperator(Ctx, sep_x_ref,
+              UO_PostInc, Ctx.IntTy), createCompoundStmt(Ctx, loop_body));
+    };
+
+    Stmt *loops[] = {
+      createDeclStmt(Ctx, sep_x),
+      createLoop(lower, true, true),
+      createLoop(createConditionalOperator(Ctx, createBinaryOperator(Ctx,
+              last_x, upper, BO_LT, Ctx.BoolTy), last_x, upper, Ctx.IntTy),
+          !split_x, !split_x),
+      createLoop(last_x, true, true)
+    };
+    return createCompoundStmt(Ctx, loops);
+  };
+
+  for (auto &conv : sepConvs) {
+    body.push_back(createColumnLoops(conv.mask, conv.lower_x,
+          [&] (Expr *idx, SmallVectorImpl<Stmt *> &stmts) {
+      // _sep<0>[idx] = sum_y w_y * acc(sep_x, y);
+      Expr *sum = nullptr;
+      for (size_t y=0; y<conv.weights_y.size(); ++y) {
+        if (conv.weights_y[y] == 0)
+          continue;
+        convIdxY = y;
+        Expr *term = createWeightedExpr(Ctx, conv.weights_y[y],
+            conv.mask->getType(), Clone(conv.weighted), conv.type);
+        sum = sum ? createBinaryOperator(Ctx, sum, term, BO_Add, conv.type) :
+          term;
+        LambdaDeclMap.clear();
+      }
+      stmts.push_back(createBinaryOperator(Ctx, new (Ctx)
+            ArraySubscriptExpr(createDeclRefExpr(Ctx, conv.buffer), idx,
+              conv.type, VK_LValue, OK_Ordinary, SourceLocation()), sum,
+            BO_Assign, conv.type));
+    }));
+  }
+
+  for (auto &filter : medianFilters) {
+    int size_y = static_cast<int>(filter.mask->getSizeY());
+    body.push_back(createColumnLoops(filter.mask, filter.lower_x,
+          [&] (Expr *idx, SmallVectorImpl<Stmt *> &stmts) {
+      // _medcol<0>[idx*size_y + y] = acc(sep_x, y);
+      for (int y=0; y<size_y; ++y) {
+        convIdxY = y;
+        Expr *pixel = Clone(filter.read);
+        LambdaDeclMap.clear();
+        Expr *col_idx = createBinaryOperator(Ctx, createBinaryOperator(Ctx,
+              createParenExpr(Ctx, idx), createIntegerLiteral(Ctx, size_y),
+              BO_Mul, Ctx.IntTy), createIntegerLiteral(Ctx, y), BO_Add,
+            Ctx.IntTy);
+        stmts.push_back(createBinaryOperator(Ctx, new (Ctx)
+              ArraySubscriptExpr(createDeclRefExpr(Ctx, filter.columns),
+                col_idx, Ctx.UnsignedCharTy, VK_LValue, OK_Ordinary,
+                SourceLocation()), pixel, BO_Assign, Ctx.UnsignedCharTy));
+      }
+    }));
+
+    // hipaccMedianRow(_medcol<0>, size_x, size_y, start-lower_x, end-start,
+    //                 _med<0>);
+    QualType argTypes[] = {
+      Ctx.getPointerType(Ctx.UnsignedCharTy.withConst()), Ctx.IntTy,
+      Ctx.IntTy, Ctx.IntTy, Ctx.IntTy, Ctx.getPointerType(Ctx.UnsignedCharTy)
+    };
+    std::string argNames[] = {
+      "cols", "size_x", "size_y", "first", "count", "out"
+    };
+    FunctionDecl *median_row = createFunctionDecl(Ctx,
+        Ctx.getTranslationUnitDecl(), "hipaccMedianRow", Ctx.VoidTy, argTypes,
+        argNames);
+    Expr *first = start;
+    if (filter.lower_x)
+      first = createBinaryOperator(Ctx, start, filter.lower_x, BO_Sub,
+          Ctx.IntTy);
+    Expr *args[] = {
+      createImplicitCastExpr(Ctx, argTypes[0], CK_ArrayToPointerDecay,
+          createDeclRefExpr(Ctx, filter.columns), nullptr, VK_RValue),
+      createIntegerLiteral(Ctx, static_cast<int32_t>(
+            filter.mask->getSizeX())),
+      createIntegerLiteral(Ctx, size_y), first,
+      createBinaryOperator(Ctx, end, start, BO_Sub, Ctx.IntTy),
+      createImplicitCastExpr(Ctx, argTypes[5], CK_ArrayToPointerDecay,
+          createDeclRefExpr(Ctx, filter.buffer), nullptr, VK_RValue)
+    };
+    body.push_back(createFunctionCall(Ctx, median_row, args));
+  }
+
+  for (auto &sum : slidingSums) {
+    int size_y = static_cast<int>(sum.mask->getSizeY());
+    auto column = [&] (Expr *idx) -> Expr * {
+      return new (Ctx) ArraySubscriptExpr(createDeclRefExpr(Ctx, sum.columns),
+          idx, sum.type, VK_LValue, OK_Ordinary, SourceLocation());
+    };
+
+    // _col<0>[idx] = sum_y acc(sep_x, y);
+    Stmt *init = createColumnLoops(sum.mask, sum.lower_x,
+          [&] (Expr *idx, SmallVectorImpl<Stmt *> &stmts) {
+      Expr *col_sum = nullptr;
+      for (int y=0; y<size_y; ++y) {
+        convIdxY = y;
+        Expr *term = Clone(sum.read);
+        col_sum = col_sum ? createBinaryOperator(Ctx, col_sum, term, BO_Add,
+            sum.type) : term;
+        LambdaDeclMap.clear();
+      }
+      stmts.push_back(createBinaryOperator(Ctx, column(idx), col_sum,
+            BO_Assign, sum.type));
+    });
+
+    // _col<0>[idx] += acc(sep_x, size_y-1); _col<0>[idx] -= acc(sep_x, -1);
+    Stmt *update = createColumnLoops(sum.mask, sum.lower_x,
+          [&] (Expr *idx, SmallVectorImpl<Stmt *> &stmts) {
+      convIdxY = size_y-1;
+      Expr *next = Clone(sum.read);
+      LambdaDeclMap.clear();
+      // the row leaving the window is above the window of the current row,
+      // hence it may be outside the image also for rows of the interior
+      bool top_row = bh_variant.borders.top;
+      bh_variant.borders.top = 1;
+      convIdxY = -1;
+      Expr *prev = Clone(sum.read);
+      LambdaDeclMap.clear();
+      bh_variant.borders.top = top_row;
+      stmts.push_back(createCompoundAssignOperator(Ctx, column(idx), next,
+            BO_AddAssign, sum.type));
+      stmts.push_back(createCompoundAssignOperator(Ctx, column(idx), prev,
+            BO_SubAssign, sum.type));
+    });
+    body.push_back(createIfStmt(Ctx, createBinaryOperator(Ctx,
+            tileVars.global_id_y, first_y, BO_EQ, Ctx.BoolTy), init, update));
+
+    // hipaccSlidingSumRow(_col<0>, size_x, start-lower_x, end-start, _box<0>);
+    QualType argTypes[] = {
+      Ctx.getPointerType(sum.type.withConst()), Ctx.IntTy, Ctx.IntTy,
+      Ctx.IntTy, Ctx.getPointerType(sum.type)
+    };
+    std::string argNames[] = { "cols", "size_x", "first", "count", "out" };
+    FunctionDecl *sum_row = createFunctionDecl(Ctx,
+        Ctx.getTranslationUnitDecl(), "hipaccSlidingSumRow", Ctx.VoidTy,
+        argTypes, argNames);
+    Expr *first = start;
+    if (sum.lower_x)
+      first = createBinaryOperator(Ctx, start, sum.lower_x, BO_Sub,
+          Ctx.IntTy);
+    Expr *args[] = {
+      createImplicitCastExpr(Ctx, argTypes[0], CK_ArrayToPointerDecay,
+          createDeclRefExpr(Ctx, sum.columns), nullptr, VK_RValue),
+      createIntegerLiteral(Ctx, static_cast<int32_t>(sum.mask->getSizeX())),
+      first, createBinaryOperator(Ctx, end, start, BO_Sub, Ctx.IntTy),
+      createImplicitCastExpr(Ctx, argTypes[4], CK_ArrayToPointerDecay,
+          createDeclRefExpr(Ctx, sum.buffer), nullptr, VK_RValue)
+    };
+    body.push_back(createFunctionCall(Ctx, sum_row, args));
+  }
+
+  return createCompoundStmt(Ctx, body);
+}
+
+
+//
+// select the median of the values of all iterations by a sorting network,
+// Batcher's odd-even merge sort for n values. Only the compare-exchanges the
+// median depends on are kept, and of those with only one output in use only
+// min or max is computed (24 of 28 compare-exchanges for 3x3, 113 of 140 for
+// 5x5):
+//
+//     _tmp<0>_s = min(v<i>, v<j>); v<j> = max(v<i>, v<j>); v<i> = _tmp<0>_s;
+//     ...
+//     _tmp<0> = v<(n-1)/2>;
+//
+void ASTTranslate::addMedianSelection(const MedianSelection &median,
+    CompoundStmt *outerCompountStmt) {
+  struct CompareExchange { size_t lo, hi; bool min, max; };
+  SmallVector<CompareExchange, 128> network, selection;
+  size_t n = median.values.size();
+  assert(n && "median of empty Mask/Domain");
+
+  for (size_t p=1; p<n; p<<=1)
+    for (size_t k=p; k>=1; k>>=1)
+      for (size_t j=k%p; j+k<n; j+=2*k)
+        for (size_t i=0; i<std::min(k, n-j-k); ++i)
+          if ((i+j)/(2*p) == (i+j+k)/(2*p))
+            network.push_back({ i+j, i+j+k, true, true });
+
+  // walk backwards from the median, keeping the compare-exchanges whose
+  // outputs are used
+  SmallVector<bool, 64> used(n, false);
+  used[(n-1)/2] = true;
+  for (auto it=network.rbegin(); it!=network.rend(); ++it) {
+    CompareExchange ce = *it;
+    ce.min = used[ce.lo];
+    ce.max = used[ce.hi];
+    if (!ce.min && !ce.max)
+      continue;
+    used[ce.lo] = used[ce.hi] = true;
+    selection.insert(selection.begin(), ce);
+  }
+
+  QualType QT = median.tmp->getType();
+  FunctionDecl *min_fun = lookup<FunctionDecl>(std::string("min"), QT,
+      hipacc_math_ns);
+  FunctionDecl *max_fun = lookup<FunctionDecl>(std::string("max"), QT,
+      hipacc_math_ns);
+  assert(min_fun && max_fun && "could not lookup 'min' or 'max'");
+
+  auto addStmt = [&] (Stmt *S) {
+    preStmts.push_back(S);
+    preCStmt.push_back(outerCompountStmt);
+  };
+  auto rvalue = [&] (DeclRefExpr *DRE) -> Expr * {
+    return createImplicitCastExpr(Ctx, QT, CK_LValueToRValue, DRE, nullptr,
+        VK_RValue);
+  };
+  auto call = [&] (FunctionDecl *fun, DeclRefExpr *lhs, DeclRefExpr *rhs) ->
+      Expr * {
+    Expr *args[] = { rvalue(lhs), rvalue(rhs) };
+    return createFunctionCall(Ctx, fun, args);
+  };
+
+  DeclRefExpr *swap = nullptr;
+  for (auto &ce : selection) {
+    DeclRefExpr *lo = median.values[ce.lo], *hi = median.values[ce.hi];
+    if (ce.min && ce.max) {
+      if (!swap) {
+        VarDecl *swap_decl = createVarDecl(Ctx, kernelDecl,
+            median.tmp->getDecl()->getName().str() + "_s", QT);
+        FunctionDecl::castToDeclContext(kernelDecl)->addDecl(swap_decl);
+        addStmt(createDeclStmt(Ctx, swap_decl));
+        swap = createDeclRefExpr(Ctx, swap_decl);
+      }
+      addStmt(createBinaryOperator(Ctx, swap, call(min_fun, lo, hi),
+            BO_Assign, QT));
+      addStmt(createBinaryOperator(Ctx, hi, call(max_fun, lo, hi), BO_Assign,
+            QT));
+      addStmt(createBinaryOperator(Ctx, lo, rvalue(swap), BO_Assign, QT));
+    } else if (ce.min) {
+      addStmt(createBinaryOperator(Ctx, lo, call(min_fun, lo, hi), BO_Assign,
+            QT));
+    } else {
+      addStmt(createBinaryOperator(Ctx, hi, call(max_fun, lo, hi), BO_Assign,
+            QT));
+    }
+  }
+
+  addStmt(createBinaryOperator(Ctx, median.tmp, rvalue(median.values[(n-1)/2]),
+        BO_Assign, QT));
+}
+
+
 // check if we have a convolve/reduce/iterate method and convert it
 Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
   enum class Method : uint8_t {
@@ -362,15 +1147,27 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
     }
   }
 
+  // the median is selected from the values of all iterations
+  bool median = (method==Method::Convolve && convMode==Reduce::MEDIAN) ||
+                (method==Method::Reduce && redModes.back()==Reduce::MEDIAN);
+  if (median && Mask->isDomain() && !Mask->isConstant()) {
+    unsigned DiagIDMedian = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+        "Reduce::MEDIAN requires a constant Domain.");
+    Diags.Report(E->getArg(0)->getExprLoc(), DiagIDMedian);
+    exit(EXIT_FAILURE);
+  }
+
   // init temporary variable depending on aggregation mode
   Expr *init = nullptr;
   switch (method) {
     case Method::Convolve:
-      init = getInitExpr(convMode, LE->getCallOperator()->getReturnType());
+      if (!median)
+        init = getInitExpr(convMode, LE->getCallOperator()->getReturnType());
       break;
     case Method::Reduce:
-      init = getInitExpr(redModes.back(),
-          LE->getCallOperator()->getReturnType());
+      if (!median)
+        init = getInitExpr(redModes.back(),
+            LE->getCallOperator()->getReturnType());
       break;
     case Method::Iterate: break;
   }
@@ -403,7 +1200,67 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
   }
 
   // unroll Mask/Domain
-  for (size_t y=0; y<Mask->getSizeY(); ++y) {
+  bool unrolled = false;
+  for (auto &conv : sepConvs) {
+    if (method!=Method::Convolve || conv.call!=E)
+      continue;
+    // horizontal pass over the line buffer of the separable convolution:
+    // _tmp<0> += w_x * _sep<0>[gid_x-lower_x+x];
+    Expr *idx = tileVars.global_id_x;
+    if (conv.lower_x)
+      idx = createBinaryOperator(Ctx, idx, conv.lower_x, BO_Sub, Ctx.IntTy);
+    for (size_t x=0; x<conv.weights_x.size(); ++x) {
+      if (conv.weights_x[x] == 0)
+        continue;
+      Expr *pixel = new (Ctx) ArraySubscriptExpr(createDeclRefExpr(Ctx,
+            conv.buffer), createBinaryOperator(Ctx, idx,
+              createIntegerLiteral(Ctx, static_cast<int32_t>(x)), BO_Add,
+              Ctx.IntTy), conv.type, VK_LValue, OK_Ordinary, SourceLocation());
+      preStmts.push_back(getConvolutionStmt(Reduce::SUM, convTmp,
+            createWeightedExpr(Ctx, conv.weights_x[x], Mask->getType(), pixel,
+              conv.type)));
+      preCStmt.push_back(outerCompountStmt);
+    }
+    unrolled = true;
+  }
+  for (auto &filter : medianFilters) {
+    if (method!=Method::Convolve || filter.call!=E)
+      continue;
+    // median of the sliding histogram: _tmp<0> = _med<0>[gid_x-lower_x];
+    Expr *idx = tileVars.global_id_x;
+    if (filter.lower_x)
+      idx = createBinaryOperator(Ctx, idx, filter.lower_x, BO_Sub, Ctx.IntTy);
+    preStmts.push_back(createBinaryOperator(Ctx, convTmp, new (Ctx)
+          ArraySubscriptExpr(createDeclRefExpr(Ctx, filter.buffer), idx,
+            Ctx.UnsignedCharTy, VK_LValue, OK_Ordinary, SourceLocation()),
+          BO_Assign, convTmp->getType()));
+    preCStmt.push_back(outerCompountStmt);
+    unrolled = true;
+  }
+  for (auto &sum : slidingSums) {
+    if (method==Method::Iterate || sum.call!=E)
+      continue;
+    // sum of the sliding window: _tmp<0> += weight * _box<0>[gid_x-lower_x];
+    Expr *idx = tileVars.global_id_x;
+    if (sum.lower_x)
+      idx = createBinaryOperator(Ctx, idx, sum.lower_x, BO_Sub, Ctx.IntTy);
+    Expr *window = new (Ctx) ArraySubscriptExpr(createDeclRefExpr(Ctx,
+          sum.buffer), idx, sum.type, VK_LValue, OK_Ordinary,
+        SourceLocation());
+    if (sum.weight)
+      window = createBinaryOperator(Ctx, Clone(sum.weight), window, BO_Mul,
+          sum.type);
+    preStmts.push_back(getConvolutionStmt(Reduce::SUM, tmp_dre, window));
+    preCStmt.push_back(outerCompountStmt);
+    unrolled = true;
+  }
+  if (!unrolled && median)
+    medians.push_back({ tmp_dre, {} });
+  if (!unrolled && method==Method::Convolve && compilerOptions.emitC99() &&
+      Mask->isConstant() && convMode==Reduce::SUM) {
+    unrolled = convertConstantConvolution(Mask, FD, LE, outerCompountStmt);
+  }
+  for (size_t y=0; !unrolled && y<Mask->getSizeY(); ++y) {
     for (size_t x=0; x<Mask->getSizeX(); ++x) {
       bool doIterate = true;
 
@@ -413,6 +1270,17 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
       }
 
       if (doIterate) {
+        if (median) {
+          // <type> _tmp<0>_<i>; holds the value of this iteration
+          VarDecl *val_decl = createVarDecl(Ctx, kernelDecl, tmp_lit + "_" +
+              std::to_string(medians.back().values.size()),
+              LE->getCallOperator()->getReturnType());
+          DC->addDecl(val_decl);
+          medians.back().values.push_back(createDeclRefExpr(Ctx, val_decl));
+          preStmts.push_back(createDeclStmt(Ctx, val_decl));
+          preCStmt.push_back(outerCompountStmt);
+        }
+
         Stmt *iteration = nullptr;
         switch (method) {
           case Method::Convolve:
@@ -447,6 +1315,11 @@ Expr *ASTTranslate::convertConvolution(CXXMemberCallExpr *E) {
     }
   }
 
+  if (!unrolled && median) {
+    addMedianSelection(medians.back(), outerCompountStmt);
+    medians.pop_back();
+  }
+
   // reset global variables
   switch (method) {
     case Method::Convolve:
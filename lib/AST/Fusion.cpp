@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+//===--- Fusion.cpp - Inline Producer Kernels into Consumer Kernels -------===//
+//
+// This file implements the inlining of fused producer kernels (C/C++).
+//
+//===----------------------------------------------------------------------===//
+
+#include "hipacc/AST/ASTTranslate.h"
+
+using namespace clang;
+using namespace hipacc;
+using namespace ASTNode;
+
+
+// replace the read of a fused Accessor at (idx_x, idx_y) by the body of the
+// producer kernel evaluated at that position, i.e. recompute the pixel:
+// ({ int _fx0 = idx_x; int _fy0 = idx_y; T _fused0; body; _fused0; })
+Expr *ASTTranslate::inlineFusedKernel(DeclRefExpr *LHS, const
+    HipaccKernel::FusedKernel *fusion, Expr *idx_x, Expr *idx_y) {
+  DeclContext *DC = FunctionDecl::castToDeclContext(kernelDecl);
+  QualType QT = LHS->getType()->getPointeeType()->getAsArrayTypeUnsafe()->
+    getElementType();
+  std::string lit(std::to_string(literalCount++));
+
+  VarDecl *fx = createVarDecl(Ctx, DC, "_fx" + lit, Ctx.IntTy, idx_x);
+  VarDecl *fy = createVarDecl(Ctx, DC, "_fy" + lit, Ctx.IntTy, idx_y);
+  VarDecl *out = createVarDecl(Ctx, DC, "_fused" + lit, QT, nullptr);
+  DC->addDecl(fx);
+  DC->addDecl(fy);
+  DC->addDecl(out);
+
+  // translate the producer in its own context: its members are the prefixed
+  // parameters and its gid_x/gid_y are the position read by the consumer
+  HipaccKernelClass *savedKernelClass = KernelClass;
+  Expr *savedGidX = tileVars.global_id_x;
+  Expr *savedGidY = tileVars.global_id_y;
+  Expr *savedGidYRef = gidYRef;
+  CompoundStmt *savedCStmt = curCStmt;
+  Expr *savedWriteImageRHS = writeImageRHS;
+  HipaccMask *savedConvMask = convMask;
+  SmallVector<HipaccMask *, 4> savedRedDomains;
+  DeclMapTy savedDeclMap, savedLambdaDeclMap;
+  savedRedDomains.swap(redDomains);
+  savedDeclMap.swap(KernelDeclMap);
+  savedLambdaDeclMap.swap(LambdaDeclMap);
+
+  KernelClass = fusion->kernel->getKernelClass();
+  tileVars.global_id_x = createDeclRefExpr(Ctx, fx);
+  tileVars.global_id_y = createDeclRefExpr(Ctx, fy);
+  gidYRef = tileVars.global_id_y;
+  convMask = nullptr;
+  fusedPrefix = fusion->field->getNameAsString() + "_";
+  fusedOutput = out;
+
+  Stmt *body = Clone(KernelClass->getKernelFunction()->getBody());
+
+  fusedOutput = nullptr;
+  fusedPrefix.clear();
+  KernelClass = savedKernelClass;
+  tileVars.global_id_x = savedGidX;
+  tileVars.global_id_y = savedGidY;
+  gidYRef = savedGidYRef;
+  curCStmt = savedCStmt;
+  writeImageRHS = savedWriteImageRHS;
+  convMask = savedConvMask;
+  redDomains.swap(savedRedDomains);
+  KernelDeclMap.swap(savedDeclMap);
+  LambdaDeclMap.swap(savedLambdaDeclMap);
+
+  SmallVector<Stmt *, 16> stmts;
+  stmts.push_back(createDeclStmt(Ctx, fx));
+  stmts.push_back(createDeclStmt(Ctx, fy));
+  stmts.push_back(createDeclStmt(Ctx, out));
+  stmts.push_back(body);
+  stmts.push_back(createDeclRefExpr(Ctx, out));
+
+  return new (Ctx) StmtExpr(createCompoundStmt(Ctx, stmts), QT,
+      SourceLocation(), SourceLocation());
+}
+
+// vim: set ts=2 sw=2 sts=2 et ai:
+
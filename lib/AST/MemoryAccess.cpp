@@ -221,6 +221,32 @@ Expr *ASTTranslate::accessMem2DAt(DeclRefExpr *LHS, Expr *idx_x, Expr *idx_y) {
   QualType QT = LHS->getType();
   QualType QT2 = QT->getPointeeType()->getAsArrayTypeUnsafe()->getElementType();
 
+  // Accessor computed by a fused producer kernel: recompute the pixel
+  if (fusedPrefix.empty()) {
+    for (auto &fusion : Kernel->getFusedKernels()) {
+      if (LHS->getNameInfo().getAsString() == fusion.field->getNameAsString())
+        return inlineFusedKernel(LHS, &fusion, idx_x, idx_y);
+    }
+  }
+
+  // pixel of a sliding window rotated through registers
+  if (auto reg = getWindowRegister(LHS, idx_x, idx_y))
+    return reg;
+
+  // ring buffer of a streamed kernel chain: wrap the row index
+  for (auto img : KernelClass->getImgFields()) {
+    if (LHS->getNameInfo().getAsString() != fusedPrefix + img->getNameAsString())
+      continue;
+    HipaccAccessor *Acc = Kernel->getImgFromMapping(img);
+    if (Acc && Acc->getImage()->getRingRows()) {
+      idx_y = createBinaryOperator(Ctx, createParenExpr(Ctx, idx_y),
+          createIntegerLiteral(Ctx,
+            static_cast<int32_t>(Acc->getImage()->getRingRows()-1)), BO_And,
+          Ctx.IntTy);
+    }
+    break;
+  }
+
   // mark image as being used within the kernel
   Kernel->setUsed(LHS->getNameInfo().getAsString());
 
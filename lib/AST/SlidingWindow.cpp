@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2013, University of Erlangen-Nuremberg
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+//===--- SlidingWindow.cpp - Rotate Windows through Registers -------------===//
+//
+// This file implements the rotation of sliding windows through registers
+// along the rows of C/C++ kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#include "hipacc/AST/ASTTranslate.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace clang;
+using namespace hipacc;
+using namespace ASTNode;
+
+
+namespace {
+// index as sum of signed terms and a constant
+struct LinearIndex {
+  SmallVector<std::pair<bool, Expr *>, 4> terms;
+  int64_t constant = 0;
+};
+
+void decompose(Expr *E, bool negate, LinearIndex &idx) {
+  E = E->IgnoreParenImpCasts();
+  if (auto IL = dyn_cast<IntegerLiteral>(E)) {
+    int64_t val = IL->getValue().getSExtValue();
+    idx.constant += negate ? -val : val;
+    return;
+  }
+  if (auto UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() == UO_Minus) {
+      decompose(UO->getSubExpr(), !negate, idx);
+      return;
+    }
+  }
+  if (auto BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->getOpcode() == BO_Add || BO->getOpcode() == BO_Sub) {
+      decompose(BO->getLHS(), negate, idx);
+      decompose(BO->getRHS(), BO->getOpcode() == BO_Sub ? !negate : negate,
+          idx);
+      return;
+    }
+  }
+  idx.terms.push_back(std::make_pair(negate, E));
+}
+
+// expression does not change within a row: parameters and gid_y only
+bool isRowInvariant(Stmt *S, ValueDecl *gid_y) {
+  if (!S)
+    return true;
+  if (isa<CallExpr>(S))
+    return false;
+  if (auto UO = dyn_cast<UnaryOperator>(S))
+    if (UO->isIncrementDecrementOp())
+      return false;
+  if (auto BO = dyn_cast<BinaryOperator>(S))
+    if (BO->isAssignmentOp())
+      return false;
+  if (auto DRE = dyn_cast<DeclRefExpr>(S))
+    return isa<ParmVarDecl>(DRE->getDecl()) || DRE->getDecl() == gid_y;
+  for (auto child : S->children())
+    if (!isRowInvariant(child, gid_y))
+      return false;
+  return true;
+}
+}
+
+
+// register holding the pixel LHS[idx_y][idx_x] while translating the body of a
+// column loop, nullptr if the pixel is not part of a sliding window: the pixel
+// has to be read from an Accessor with boundary handling at a constant offset
+// within the window of the Accessor, from a row not changing along the loop
+Expr *ASTTranslate::getWindowRegister(DeclRefExpr *LHS, Expr *idx_x, Expr
+    *idx_y) {
+  if (!rotateWindows || !fusedPrefix.empty())
+    return nullptr;
+
+  HipaccAccessor *Acc = nullptr;
+  for (auto img : KernelClass->getImgFields()) {
+    if (img->getNameAsString() == LHS->getNameInfo().getAsString() &&
+        KernelClass->getMemAccess(img) == READ_ONLY)
+      Acc = Kernel->getImgFromMapping(img);
+  }
+  if (!Acc || Acc == Kernel->getIterationSpace() ||
+      Acc->getBoundaryMode() == Boundary::UNDEFINED ||
+      Acc->getInterpolationMode() != Interpolate::NO)
+    return nullptr;
+
+  ValueDecl *gid_x = dyn_cast<DeclRefExpr>(tileVars.global_id_x)->getDecl();
+  ValueDecl *gid_y = dyn_cast<DeclRefExpr>(tileVars.global_id_y)->getDecl();
+  LinearIndex lin_x, lin_y;
+  decompose(idx_x, false, lin_x);
+  decompose(idx_y, false, lin_y);
+
+  // idx_x = gid_x + invariant terms + constant
+  bool has_gid_x = false;
+  SmallVector<std::pair<bool, Expr *>, 4> terms_x;
+  for (auto term : lin_x.terms) {
+    auto DRE = dyn_cast<DeclRefExpr>(term.second);
+    if (DRE && DRE->getDecl() == gid_x && !term.first && !has_gid_x) {
+      has_gid_x = true;
+      continue;
+    }
+    if (!isRowInvariant(term.second, gid_y))
+      return nullptr;
+    terms_x.push_back(term);
+  }
+  if (!has_gid_x || std::abs(lin_x.constant) > Acc->getSizeX()/2)
+    return nullptr;
+  for (auto term : lin_y.terms)
+    if (!isRowInvariant(term.second, gid_y))
+      return nullptr;
+
+  // windows are identified by the image, the row, and the invariant terms of
+  // the column; rows computed per iteration share their windows
+  auto printTerms = [&] (ArrayRef<std::pair<bool, Expr *>> terms) {
+    SmallVector<std::string, 4> strs;
+    for (auto term : terms) {
+      std::string str(term.first ? "-" : "+");
+      llvm::raw_string_ostream OS(str);
+      term.second->printPretty(OS, nullptr, PrintingPolicy(Ctx.getLangOpts()));
+      strs.push_back(OS.str());
+    }
+    std::sort(strs.begin(), strs.end());
+    std::string key;
+    for (auto &str : strs)
+      key += str;
+    return key;
+  };
+  std::string key(LHS->getNameInfo().getAsString() + "[" +
+      printTerms(lin_y.terms) + std::to_string(lin_y.constant) + "][" +
+      printTerms(terms_x) + "]");
+
+  SlidingWindow *window = nullptr;
+  for (auto &win : slidingWindows)
+    if (win.key == key)
+      window = &win;
+  if (!window) {
+    SlidingWindow win;
+    win.key = key;
+    win.image = LHS;
+    win.idx_y = idx_y;
+    win.terms_x = terms_x;
+    win.type = LHS->getType()->getPointeeType()->getAsArrayTypeUnsafe()->
+      getElementType().getUnqualifiedType();
+    slidingWindows.push_back(win);
+    window = &slidingWindows.back();
+  }
+
+  int column = static_cast<int>(lin_x.constant);
+  VarDecl *&reg = window->columns[column];
+  if (!reg) {
+    reg = createVarDecl(Ctx, kernelDecl, "_win" +
+        std::to_string(literalCount++), window->type, nullptr);
+    FunctionDecl::castToDeclContext(kernelDecl)->addDecl(reg);
+  }
+
+  return createDeclRefExpr(Ctx, reg);
+}
+
+
+// column loop reading the sliding windows collected for its body:
+// if (gid_x < upper) {
+//     T _win0 = in[y][gid_x-1], _win1 = in[y][gid_x], _win2;
+//     for (; gid_x<upper; gid_x++) {
+//         _win2 = in[y][gid_x+1];
+//         body
+//         _win0 = _win1; _win1 = _win2;
+//     }
+// }
+Stmt *ASTTranslate::createWindowLoop(Expr *upper, Expr *inc, Stmt *body) {
+  Expr *cond = createBinaryOperator(Ctx, tileVars.global_id_x, upper, BO_LT,
+      Ctx.BoolTy);
+  if (slidingWindows.empty())
+    return createForStmt(Ctx, nullptr, cond, inc, body);
+
+  // the loads of the windows access the images
+  bool rotate = rotateWindows;
+  rotateWindows = false;
+
+  SmallVector<Stmt *, 16> decls, loads, rotation;
+  for (auto &win : slidingWindows) {
+    int min_x = win.columns.begin()->first;
+    int max_x = win.columns.rbegin()->first;
+    for (int x=min_x; x<max_x; ++x) {
+      VarDecl *&reg = win.columns[x];
+      if (!reg) {
+        reg = createVarDecl(Ctx, kernelDecl, "_win" +
+            std::to_string(literalCount++), win.type, nullptr);
+        FunctionDecl::castToDeclContext(kernelDecl)->addDecl(reg);
+      }
+    }
+
+    for (auto &col : win.columns) {
+      Expr *idx_x = tileVars.global_id_x;
+      for (auto term : win.terms_x)
+        idx_x = createBinaryOperator(Ctx, idx_x, term.second, term.first ?
+            BO_Sub : BO_Add, Ctx.IntTy);
+      if (col.first)
+        idx_x = createBinaryOperator(Ctx, idx_x, createIntegerLiteral(Ctx,
+              col.first), BO_Add, Ctx.IntTy);
+      Expr *read = accessMem2DAt(win.image, idx_x, win.idx_y);
+
+      VarDecl *reg = col.second;
+      if (col.first < max_x) {
+        reg->setInit(read);
+        rotation.push_back(createBinaryOperator(Ctx, createDeclRefExpr(Ctx,
+                reg), createDeclRefExpr(Ctx, win.columns[col.first+1]),
+              BO_Assign, win.type));
+      } else {
+        loads.push_back(createBinaryOperator(Ctx, createDeclRefExpr(Ctx, reg),
+              read, BO_Assign, win.type));
+      }
+      decls.push_back(createDeclStmt(Ctx, reg));
+    }
+  }
+  slidingWindows.clear();
+  rotateWindows = rotate;
+
+  SmallVector<Stmt *, 16> loopBody(loads.begin(), loads.end());
+  loopBody.push_back(body);
+  loopBody.append(rotation.begin(), rotation.end());
+  decls.push_back(createForStmt(Ctx, nullptr, cond, inc,
+        createCompoundStmt(Ctx, loopBody)));
+
+  return createIfStmt(Ctx, cond, createCompoundStmt(Ctx, decls));
+}
+
+// vim: set ts=2 sw=2 sts=2 et ai:
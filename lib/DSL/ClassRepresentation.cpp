@@ -490,6 +490,39 @@ void HipaccKernel::addParam(QualType QT1, QualType QT2, QualType QT3,
 void HipaccKernel::createArgInfo() {
   if (argTypes.size()) return;
 
+  auto addImageParams = [&] (QualType QT, std::string name, FieldDecl *field) {
+    // for textures use no pointer type
+    if (useTextureMemory(getImgFromMapping(field)) != Texture::None &&
+        useTextureMemory(getImgFromMapping(field)) != Texture::Ldg) {
+      addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
+          Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
+                getImgFromMapping(field)->getImage()->getSizeX()),
+              ArrayType::Normal, false)), QT.getAsString(), "cl_mem",
+          name, field);
+    } else {
+      addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
+          Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
+                getImgFromMapping(field)->getImage()->getSizeX()),
+              ArrayType::Normal, false)),
+          Ctx.getPointerType(QT).getAsString(), "cl_mem", name, field);
+    }
+
+    // add types for image width/height plus stride
+    addParam(Ctx.getConstType(Ctx.IntTy), name + "_width", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), name + "_height", nullptr);
+
+    // stride
+    if (options.emitPadding() || getImgFromMapping(field)->isCrop()) {
+      addParam(Ctx.getConstType(Ctx.IntTy), name + "_stride", nullptr);
+    }
+
+    // offset_x, offset_y
+    if (getImgFromMapping(field)->isCrop()) {
+      addParam(Ctx.getConstType(Ctx.IntTy), name + "_offset_x", nullptr);
+      addParam(Ctx.getConstType(Ctx.IntTy), name + "_offset_y", nullptr);
+    }
+  };
+
   // normal parameters
   for (auto arg : KC->getMembers()) {
     QualType QT = arg.type;
@@ -502,39 +535,7 @@ void HipaccKernel::createArgInfo() {
         break;
       case HipaccKernelClass::FieldKind::IterationSpace:
       case HipaccKernelClass::FieldKind::Image:
-        // for textures use no pointer type
-        if (useTextureMemory(getImgFromMapping(arg.field)) != Texture::None &&
-            useTextureMemory(getImgFromMapping(arg.field)) != Texture::Ldg) {
-          addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
-              Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
-                    getImgFromMapping(arg.field)->getImage()->getSizeX()),
-                  ArrayType::Normal, false)), QT.getAsString(), "cl_mem",
-              arg.name, arg.field);
-        } else {
-          addParam(Ctx.getPointerType(QT), Ctx.getPointerType(QT),
-              Ctx.getPointerType(Ctx.getConstantArrayType(QT, llvm::APInt(32,
-                    getImgFromMapping(arg.field)->getImage()->getSizeX()),
-                  ArrayType::Normal, false)),
-              Ctx.getPointerType(QT).getAsString(), "cl_mem", arg.name,
-              arg.field);
-        }
-
-        // add types for image width/height plus stride
-        addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_width", nullptr);
-        addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_height", nullptr);
-
-        // stride
-        if (options.emitPadding() || getImgFromMapping(arg.field)->isCrop()) {
-          addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_stride", nullptr);
-        }
-
-        // offset_x, offset_y
-        if (getImgFromMapping(arg.field)->isCrop()) {
-          addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_offset_x",
-              nullptr);
-          addParam(Ctx.getConstType(Ctx.IntTy), arg.name + "_offset_y",
-              nullptr);
-        }
+        addImageParams(QT, arg.name, arg.field);
 
         break;
       case HipaccKernelClass::FieldKind::Mask:
@@ -553,6 +554,25 @@ void HipaccKernel::createArgInfo() {
     }
   }
 
+  // parameters of fused producer kernels, prefixed by the name of the
+  // Accessor they replace; the output of the producer is not passed
+  for (auto &fusion : fusedKernels) {
+    std::string prefix = fusion.field->getNameAsString() + "_";
+    for (auto arg : fusion.kernel->getKernelClass()->getMembers()) {
+      switch (arg.kind) {
+        case HipaccKernelClass::FieldKind::Normal:
+          addParam(arg.type, prefix + arg.name, arg.field);
+          break;
+        case HipaccKernelClass::FieldKind::Image:
+          addImageParams(arg.type, prefix + arg.name, arg.field);
+          break;
+        case HipaccKernelClass::FieldKind::IterationSpace:
+        case HipaccKernelClass::FieldKind::Mask:
+          break;
+      }
+    }
+  }
+
   // bh_start_left
   if (getMaxSizeX() || options.exploreConfig()) {
     addParam(Ctx.getConstType(Ctx.IntTy), "bh_start_left", nullptr);
@@ -574,6 +594,12 @@ void HipaccKernel::createArgInfo() {
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     addParam(Ctx.getConstType(Ctx.IntTy), "bh_fall_back", nullptr);
   }
+  // cpu_start_y, cpu_end_y: band of rows processed by one CPU thread or one
+  // step of a streamed kernel chain
+  if (options.emitC99() && (options.useCPUThreads() || streamed)) {
+    addParam(Ctx.getConstType(Ctx.IntTy), "cpu_start_y", nullptr);
+    addParam(Ctx.getConstType(Ctx.IntTy), "cpu_end_y", nullptr);
+  }
 }
 
 
@@ -581,55 +607,70 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
     &hostLiterals, unsigned &literalCount) {
   if (hostArgNames.size()) hostArgNames.clear();
 
+  auto addNormalArg = [&] (Expr *hostArg, QualType QT) {
+    std::string Str;
+    llvm::raw_string_ostream SS(Str);
+    hostArg->printPretty(SS, 0, PrintingPolicy(Ctx.getLangOpts()));
+
+    if (isa<DeclRefExpr>(hostArg->IgnoreParenCasts())) {
+      hostArgNames.push_back(SS.str());
+    } else {
+      // get the text string for the argument and create a temporary
+      std::string tmp_lit("_tmpLiteral" + std::to_string(literalCount++));
+
+      // use type of kernel class
+      hostLiterals += QT.getAsString();
+      hostLiterals += " ";
+      hostLiterals += tmp_lit;
+      hostLiterals += " = ";
+      hostLiterals += SS.str();
+      hostLiterals += ";\n    ";
+      hostArgNames.push_back(tmp_lit);
+    }
+  };
+
+  auto addImageArgs = [&] (HipaccAccessor *Acc) {
+    // image
+    hostArgNames.push_back(Acc->getName() + ".img");
+
+    // width, height
+    hostArgNames.push_back(Acc->getName() + ".width");
+    hostArgNames.push_back(Acc->getName() + ".height");
+
+    // stride
+    if (options.emitPadding() || Acc->isCrop()) {
+      hostArgNames.push_back(Acc->getName() + ".img.stride");
+    }
+
+    // offset_x, offset_y
+    if (Acc->isCrop()) {
+      hostArgNames.push_back(Acc->getName() + ".offset_x");
+      hostArgNames.push_back(Acc->getName() + ".offset_y");
+    }
+  };
+
   size_t i = 0;
   for (auto arg : KC->getMembers()) {
     switch (arg.kind) {
-      case HipaccKernelClass::FieldKind::Normal: {
-        std::string Str;
-        llvm::raw_string_ostream SS(Str);
-        hostArgs[i]->printPretty(SS, 0, PrintingPolicy(Ctx.getLangOpts()));
-
-        if (isa<DeclRefExpr>(hostArgs[i]->IgnoreParenCasts())) {
-          hostArgNames.push_back(SS.str());
-        } else {
-          // get the text string for the argument and create a temporary
-          std::string tmp_lit("_tmpLiteral" + std::to_string(literalCount++));
-
-          // use type of kernel class
-          hostLiterals += arg.type.getAsString();
-          hostLiterals += " ";
-          hostLiterals += tmp_lit;
-          hostLiterals += " = ";
-          hostLiterals += SS.str();
-          hostLiterals += ";\n    ";
-          hostArgNames.push_back(tmp_lit);
-        }
+      case HipaccKernelClass::FieldKind::Normal:
+        addNormalArg(hostArgs[i], arg.type);
 
         break;
-        }
       case HipaccKernelClass::FieldKind::IterationSpace:
-      case HipaccKernelClass::FieldKind::Image: {
-        // image
-        HipaccAccessor *Acc = getImgFromMapping(arg.field);
-        hostArgNames.push_back(Acc->getName() + ".img");
-
-        // width, height
-        hostArgNames.push_back(Acc->getName() + ".width");
-        hostArgNames.push_back(Acc->getName() + ".height");
-
-        // stride
-        if (options.emitPadding() || Acc->isCrop()) {
-          hostArgNames.push_back(Acc->getName() + ".img.stride");
-        }
-
-        // offset_x, offset_y
-        if (Acc->isCrop()) {
-          hostArgNames.push_back(Acc->getName() + ".offset_x");
-          hostArgNames.push_back(Acc->getName() + ".offset_y");
+      case HipaccKernelClass::FieldKind::Image:
+        if (auto fusion = getFusedKernel(arg.field)) {
+          // the image of a fused Accessor does not exist on the host, only
+          // its size is passed; image and stride are never used
+          hostArgNames.push_back("NULL");
+          hostArgNames.push_back(fusion->width);
+          hostArgNames.push_back(fusion->height);
+          if (options.emitPadding())
+            hostArgNames.push_back(fusion->width);
+          break;
         }
+        addImageArgs(getImgFromMapping(arg.field));
 
         break;
-        }
       case HipaccKernelClass::FieldKind::Mask:
         hostArgNames.push_back(getMaskFromMapping(arg.field)->getName());
 
@@ -638,6 +679,27 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
     i++;
   }
 
+  // arguments of fused producer kernels are taken from their declaration
+  for (auto &fusion : fusedKernels) {
+    CXXConstructExpr *CCE =
+      dyn_cast<CXXConstructExpr>(fusion.kernel->getDecl()->getInit());
+    size_t j = 0;
+    for (auto arg : fusion.kernel->getKernelClass()->getMembers()) {
+      switch (arg.kind) {
+        case HipaccKernelClass::FieldKind::Normal:
+          addNormalArg(CCE->getArg(j), arg.type);
+          break;
+        case HipaccKernelClass::FieldKind::Image:
+          addImageArgs(getImgFromMapping(arg.field));
+          break;
+        case HipaccKernelClass::FieldKind::IterationSpace:
+        case HipaccKernelClass::FieldKind::Mask:
+          break;
+      }
+      j++;
+    }
+  }
+
   // bh_start_left, bh_start_right
   if (getMaxSizeX() || options.exploreConfig()) {
     hostArgNames.push_back(getInfoStr() + ".bh_start_left");
@@ -655,6 +717,12 @@ void HipaccKernel::createHostArgInfo(ArrayRef<Expr *> hostArgs, std::string
   if (getMaxSizeX() || getMaxSizeY() || options.exploreConfig()) {
     hostArgNames.push_back(getInfoStr() + ".bh_fall_back");
   }
+  // cpu_start_y, cpu_end_y: parameters of the row band lambda or the row
+  // computed in the current step of a streamed kernel chain
+  if (options.emitC99() && (options.useCPUThreads() || streamed)) {
+    hostArgNames.push_back("_cpu_start_y");
+    hostArgNames.push_back("_cpu_end_y");
+  }
 }
 
 // vim: set ts=2 sw=2 sts=2 et ai:
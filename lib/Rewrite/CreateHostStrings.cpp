@@ -34,6 +34,8 @@
 
 #include "hipacc/Rewrite/CreateHostStrings.h"
 
+#include <algorithm>
+
 using namespace clang;
 using namespace hipacc;
 
@@ -183,6 +185,17 @@ void CreateHostStrings::writeReductionDeclaration(HipaccKernel *K, std::string
 void CreateHostStrings::writeMemoryAllocation(HipaccImage *Img, std::string
     width, std::string height, std::string host, std::string &resultStr) {
   resultStr += "HipaccImage " + Img->getName() + " = ";
+  if (Img->getRingRows()) {
+    // intermediate image of a streamed kernel chain (C/C++)
+    resultStr += "hipaccCreateRingBuffer<" + Img->getTypeStr() + ">(";
+    resultStr += width + ", " + height + ", ";
+    resultStr += std::to_string(Img->getRingRows());
+    if (options.emitPadding()) {
+      resultStr += ", " + std::to_string(device.alignment);
+    }
+    resultStr += ");";
+    return;
+  }
   switch (options.getTargetLang()) {
     case Language::C99:
       resultStr += "hipaccCreateMemory<" + Img->getTypeStr() + ">(";
@@ -424,7 +437,8 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   }
   infoStr = K->getInfoStr();
 
-  if (options.exploreConfig() || options.timeKernels()) {
+  if (!options.emitC99() &&
+      (options.exploreConfig() || options.timeKernels())) {
     inc_indent();
     resultStr += "{\n";
     switch (options.getTargetLang()) {
@@ -620,6 +634,47 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   #endif
 
 
+  // asynchronous launches (C/C++): memory read and written by the kernel
+  bool async = options.emitC99() && options.asyncCPUKernels() &&
+               !K->isStreamed();
+  std::string input_mems, output_mems;
+  if (async) {
+    // Accessors written by the kernel are additional outputs
+    std::vector<std::string> inputs, outputs;
+    outputs.push_back(K->getIterationSpace()->getName() + ".img.mem");
+    num_arg = 0;
+    for (auto arg : K->getDeviceArgFields()) {
+      size_t i = num_arg++;
+      if (!K->getUsed(K->getDeviceArgNames()[i]))
+        continue;
+      HipaccAccessor *Acc = K->getImgFromMapping(arg);
+      if (Acc && hostArgNames[i] != "NULL" &&
+          K->getKernelClass()->getMemAccess(arg) == WRITE_ONLY) {
+        std::string mem(hostArgNames[i] + ".mem");
+        if (std::find(outputs.begin(), outputs.end(), mem) == outputs.end())
+          outputs.push_back(mem);
+      }
+    }
+    num_arg = 0;
+    for (auto arg : K->getDeviceArgFields()) {
+      size_t i = num_arg++;
+      if (!K->getUsed(K->getDeviceArgNames()[i]))
+        continue;
+      HipaccMask *Mask = K->getMaskFromMapping(arg);
+      if ((K->getImgFromMapping(arg) && hostArgNames[i] != "NULL") ||
+          (Mask && !Mask->isConstant())) {
+        std::string mem(hostArgNames[i] + ".mem");
+        if (std::find(outputs.begin(), outputs.end(), mem) == outputs.end() &&
+            std::find(inputs.begin(), inputs.end(), mem) == inputs.end())
+          inputs.push_back(mem);
+      }
+    }
+    for (auto &mem : inputs)
+      input_mems += (input_mems.empty() ? "" : ", ") + mem;
+    for (auto &mem : outputs)
+      output_mems += (output_mems.empty() ? "" : ", ") + mem;
+  }
+
   // parameters
   size_t cur_arg = 0;
   num_arg = 0;
@@ -649,7 +704,8 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
     std::string img_mem;
     if (Acc || Mask) img_mem = ".mem";
 
-    if (options.exploreConfig() || options.timeKernels()) {
+    if (!options.emitC99() &&
+        (options.exploreConfig() || options.timeKernels())) {
       // add kernel argument
       switch (options.getTargetLang()) {
         case Language::C99: break;
@@ -690,9 +746,52 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
       // set kernel arguments
       switch (options.getTargetLang()) {
         case Language::C99:
-          if (i==0) {
-            resultStr += "hipaccStartTiming();\n";
-            resultStr += indent;
+          // the row band is passed by the runtime to asynchronous launches
+          if (async && (hostArgNames[i] == "_cpu_start_y" ||
+                        hostArgNames[i] == "_cpu_end_y"))
+            break;
+          if (i==0 && async) {
+            // hipaccLaunchKernelAsync: record the kernel in the task graph,
+            // which executes it once its input is computed; not timed
+            resultStr += "hipaccLaunchKernelAsync(";
+            resultStr += K->getIterationSpace()->getName() + ", ";
+            resultStr += std::to_string(options.getCPUThreads()) + ", ";
+            resultStr += "{" + input_mems + "}, {" + output_mems + "}, ";
+            resultStr += "\"" + kernel_name + "\", " + kernel_name + ", ";
+          } else if (i==0) {
+            if (options.timeKernels()) {
+              // hipaccLaunchKernelBenchmark: execute the kernel repeatedly
+              resultStr += "hipaccLaunchKernelBenchmark(\"" + kernel_name;
+              resultStr += "\", " + K->getIterationSpace()->getName();
+              resultStr += ".width, " + K->getIterationSpace()->getName();
+              resultStr += ".height, [&] {\n";
+              inc_indent();
+              resultStr += indent;
+            } else if (options.exploreConfig()) {
+              // hipaccLaunchKernelExploration: execute bands of rows in
+              // parallel using the number of bands found fastest
+              resultStr += "hipaccLaunchKernelExploration(\"" + kernel_name;
+              resultStr += "\", " + K->getIterationSpace()->getName() + ", ";
+              resultStr += std::to_string(options.getCPUThreads()) + ", ";
+              resultStr += "[&] (int _cpu_start_y, int _cpu_end_y) {\n";
+              inc_indent();
+              resultStr += indent;
+            } else if (!K->isStreamed()) {
+              // stages of streamed kernel chains compute a single row and
+              // are timed as a whole
+              resultStr += "hipaccStartTiming();\n";
+              resultStr += indent;
+            }
+            if (options.useCPUThreads() && !K->isStreamed() &&
+                !options.exploreConfig()) {
+              // hipaccLaunchKernel: execute bands of rows in parallel
+              resultStr += "hipaccLaunchKernel(";
+              resultStr += K->getIterationSpace()->getName() + ", ";
+              resultStr += std::to_string(options.getCPUThreads()) + ", ";
+              resultStr += "[&] (int _cpu_start_y, int _cpu_end_y) {\n";
+              inc_indent();
+              resultStr += indent;
+            }
             resultStr += kernel_name + "(";
           } else {
             resultStr += ", ";
@@ -743,15 +842,39 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
   }
   if (options.getTargetLang()==Language::C99) {
     // close parenthesis for function call
+    if (K->isStreamed()) {
+      resultStr += ");";
+      return;
+    }
+    if (async) {
+      resultStr += ");\n" + indent;
+      return;
+    }
     resultStr += ");\n";
-    resultStr += indent;
-    resultStr += "hipaccStopTiming();\n";
-    resultStr += indent;
+    if (options.useCPUThreads()) {
+      dec_indent();
+      resultStr += indent + "});\n";
+    }
+    if (options.timeKernels()) {
+      dec_indent();
+      resultStr += indent + "});\n";
+      resultStr += indent;
+    } else if (options.exploreConfig()) {
+      resultStr += indent;
+    } else {
+      resultStr += indent;
+      // kernel name and iteration space size for the trace
+      resultStr += "hipaccStopTiming(\"" + kernel_name + "\", ";
+      resultStr += K->getIterationSpace()->getName() + ".width, ";
+      resultStr += K->getIterationSpace()->getName() + ".height);\n";
+      resultStr += indent;
+    }
   }
   resultStr += "\n" + indent;
 
   // launch kernel
-  if (options.exploreConfig() || options.timeKernels()) {
+  if (!options.emitC99() &&
+      (options.exploreConfig() || options.timeKernels())) {
     switch (options.getTargetLang()) {
       case Language::C99: break;
       case Language::CUDA:
@@ -850,13 +973,122 @@ void CreateHostStrings::writeKernelCall(HipaccKernel *K, std::string &resultStr)
 }
 
 
+// Bins of a kernel with binning function (C/C++): the bins are computed by
+// binned_data() and are valid until the next binned_data() call
+void CreateHostStrings::writeBinningDeclaration(HipaccKernel *K, std::string
+    &resultStr) {
+  std::string binType(K->getKernelClass()->getReduceFunction()->
+      getReturnType().getAsString());
+  resultStr += "std::vector<" + binType + "> " + K->getBinningStr() + ";";
+}
+
+
+void CreateHostStrings::writeBinningCall(HipaccKernel *K, std::string
+    num_bins, std::string weight, std::string &resultStr) {
+  std::string typeStr(K->getIterationSpace()->getImage()->getTypeStr());
+  std::string binType(K->getKernelClass()->getReduceFunction()->
+      getReturnType().getAsString());
+  std::string threads(options.useCPUThreads() ?
+      std::to_string(options.getCPUThreads()) : "1");
+
+  // histograms of 8-bit pixels count into sub-histograms
+  if (!weight.empty()) {
+    resultStr += "hipaccApplyHistogram<" + binType + ">(";
+    resultStr += K->getIterationSpace()->getName() + ", " + num_bins + ", ";
+    resultStr += "(" + binType + ")(" + weight + "), " + threads + ", ";
+    resultStr += K->getBinningStr() + ")";
+    return;
+  }
+
+  resultStr += "hipaccApplyBinning<" + typeStr + ", " + binType + ">(";
+  resultStr += K->getBinningName() + "(), ";
+  resultStr += K->getIterationSpace()->getName() + ", " + num_bins + ", ";
+  resultStr += threads + ", " + K->getBinningStr() + ")";
+}
+
+
+void CreateHostStrings::writeScanCall(HipaccKernel *K, Scan mode,
+    std::string &resultStr) {
+  std::string modeStr;
+  switch (mode) {
+    case Scan::ROW:    modeStr = "ScanRow";    break;
+    case Scan::COLUMN: modeStr = "ScanColumn"; break;
+    case Scan::IMAGE:  modeStr = "ScanImage";  break;
+  }
+
+  resultStr += "hipaccApplyScan<";
+  resultStr += K->getIterationSpace()->getImage()->getTypeStr() + ", ";
+  resultStr += K->getReduceName() + ">(";
+  resultStr += K->getIterationSpace()->getName() + ", " + modeStr + ", ";
+  if (options.useCPUThreads()) {
+    resultStr += std::to_string(options.getCPUThreads()) + ")";
+  } else {
+    resultStr += "1)";
+  }
+}
+
+
+// Execute a chain of kernels row by row (C/C++): in each step, each stage
+// computes the row its consumer stage needs next. Stage k lags behind the
+// first stage by lags[k] rows, the sum of the mask radii of the intermediate
+// images in between, so that all rows read from a ring buffer were computed
+// before and are not yet overwritten.
+void CreateHostStrings::writeStreamCall(ArrayRef<HipaccKernel *> stages,
+    ArrayRef<unsigned> lags, std::string &resultStr) {
+  std::string height = stages.back()->getIterationSpace()->getName() +
+    ".height";
+
+  // the chain is executed by the host thread, after all asynchronous launches
+  if (options.asyncCPUKernels()) {
+    resultStr += "hipaccSynchronizeKernels();\n";
+    resultStr += indent;
+  }
+  resultStr += "hipaccStartTiming();\n";
+  resultStr += indent + "for (int _stream_y=0; _stream_y<" + height + "+";
+  resultStr += std::to_string(lags.back()) + "; ++_stream_y) {\n";
+  inc_indent();
+  for (size_t i=0; i<stages.size(); ++i) {
+    std::string lag(std::to_string(lags[i]));
+    resultStr += indent + "if (_stream_y>=" + lag + " && _stream_y<";
+    resultStr += height + "+" + lag + ") {\n";
+    inc_indent();
+    resultStr += indent + "const int _cpu_start_y = _stream_y-" + lag;
+    resultStr += ", _cpu_end_y = _cpu_start_y+1;\n";
+    resultStr += indent;
+    writeKernelCall(stages[i], resultStr);
+    resultStr += "\n";
+    dec_indent();
+    resultStr += indent + "}\n";
+  }
+  dec_indent();
+  resultStr += indent + "}\n";
+  std::string names;
+  for (auto stage : stages)
+    names += (names.empty() ? "" : "+") + stage->getKernelName();
+  resultStr += indent + "hipaccStopTiming(\"" + names + "\", ";
+  resultStr += stages.back()->getIterationSpace()->getName() + ".width, ";
+  resultStr += height + ");\n";
+  resultStr += indent;
+}
+
+
 void CreateHostStrings::writeReduceCall(HipaccKernel *K, std::string &resultStr) {
   std::string typeStr(K->getIterationSpace()->getImage()->getTypeStr());
   std::string red_decl(typeStr + " " + K->getReduceStr() + " = ");
 
   // print runtime function name plus name of reduction function
   switch (options.getTargetLang()) {
-    case Language::C99: break;
+    case Language::C99:
+      resultStr += red_decl;
+      resultStr += "hipaccApplyReduction<" + typeStr + ">(";
+      resultStr += K->getReduceName() + ", ";
+      resultStr += K->getIterationSpace()->getName() + ", ";
+      if (options.useCPUThreads()) {
+        resultStr += std::to_string(options.getCPUThreads()) + ");";
+      } else {
+        resultStr += "1);";
+      }
+      return;
     case Language::CUDA:
       if (!options.exploreConfig()) {
         // first get texture reference
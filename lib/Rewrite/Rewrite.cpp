@@ -46,8 +46,12 @@
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Rewrite/Core/Rewriter.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/Support/Path.h>
 
+#include <algorithm>
+#include <functional>
+
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -89,6 +93,29 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
     llvm::DenseMap<ValueDecl *, HipaccKernel *> KernelDeclMap;
     llvm::DenseMap<ValueDecl *, HipaccMask *> MaskDeclMap;
 
+    // producer kernels fused into the consumer kernel executed next (C/C++):
+    // the consumer argument replaced by the producer and the intermediate
+    // image, whose allocation and accessors are removed
+    struct KernelFusion {
+      VarDecl *producer, *image;
+      size_t arg;
+    };
+    llvm::DenseMap<ValueDecl *, KernelFusion> FusionMap;
+    llvm::SmallPtrSet<ValueDecl *, 16> FusedDecls;
+
+    // kernel chains executed row by row through ring buffers (C/C++), stored
+    // for the last stage: the kernels and the Accessors reading the output of
+    // the previous stage; the other stages and the intermediate images
+    struct KernelStream {
+      SmallVector<VarDecl *, 4> stages, accessors;
+    };
+    llvm::DenseMap<ValueDecl *, KernelStream> StreamMap;
+    llvm::SmallPtrSet<ValueDecl *, 16> StreamedDecls;
+
+    // kernels with scan() and reduced_data() calls; scanned kernels are only
+    // reduced if the result of the reduction is used
+    llvm::SmallPtrSet<ValueDecl *, 16> ScannedDecls, ReducedDecls;
+
     // store interpolation methods required for CUDA
     SmallVector<std::string, 16> InterpolationDefinitionsGlobal;
 
@@ -160,9 +187,25 @@ class Rewrite : public ASTConsumer,  public RecursiveASTVisitor<Rewrite> {
       return LO;
     }
 
+    void countReferences(ArrayRef<Stmt *> stmts,
+        llvm::DenseMap<ValueDecl *, unsigned> &refCount,
+        llvm::DenseMap<ValueDecl *, size_t> &declPos);
+    VarDecl *getVarDecl(Expr *E);
+    VarDecl *getSingleArg(VarDecl *VD);
+    bool isOfClass(VarDecl *VD, CXXRecordDecl *RD);
+    VarDecl *getAccessorImage(VarDecl *Acc, VarDecl *&BC);
+    bool getImageSize(VarDecl *Img, int64_t &width, int64_t &height);
+    VarDecl *getExecutedKernel(Stmt *S);
+    HipaccKernelClass *getKernelClass(VarDecl *VD);
+    void findFusibleKernels(CompoundStmt *body);
+    void findStreamableKernels(CompoundStmt *body);
+    void findScannedKernels(Stmt *S);
     void setKernelConfiguration(HipaccKernelClass *KC, HipaccKernel *K);
     void printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
         llvm::raw_fd_ostream &OS);
+    void printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
+        llvm::raw_fd_ostream &OS);
+    std::string getHistogramWeight(HipaccKernelClass *KC);
     void printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
         HipaccKernel *K, std::string file, bool emitHints);
 };
@@ -399,6 +442,10 @@ void Rewrite::HandleTranslationUnit(ASTContext &) {
     auto img = map.second;
     std::string releaseStr;
 
+    // intermediate images of fused kernels are not allocated
+    if (FusedDecls.count(map.first))
+      continue;
+
     stringCreator.writeMemoryRelease(img, releaseStr);
     TextRewriter.InsertTextBefore(CS->body_back()->getLocStart(), releaseStr);
   }
@@ -633,6 +680,29 @@ bool Rewrite::VisitCXXRecordDecl(CXXRecordDecl *D) {
         KC->setReduceFunction(method);
         continue;
       }
+
+      // binning function
+      if (method->getNameAsString() == "binning") {
+        KC->setBinningFunction(method);
+        continue;
+      }
+    }
+
+    if (KC->getBinningFunction()) {
+      CXXMethodDecl *binning = KC->getBinningFunction();
+      if (!compilerOptions.emitC99()) {
+        unsigned IDBinning = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+            "Binning function of kernel %0 is only supported for C/C++.");
+        Diags.Report(binning->getLocation(), IDBinning) << KC->getName();
+        exit(EXIT_FAILURE);
+      }
+      if (!KC->getReduceFunction()) {
+        unsigned IDReduce = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+            "Binning function of kernel %0 requires a reduce function to "
+            "combine bins.");
+        Diags.Report(binning->getLocation(), IDReduce) << KC->getName();
+        exit(EXIT_FAILURE);
+      }
     }
   }
 
@@ -724,10 +794,12 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         if (CCE->getNumArgs() == 3)
           init_str = convertToString(CCE->getArg(2));
 
-        // create memory allocation string
+        // create memory allocation string; ring buffers of streamed kernel
+        // chains are allocated once their BoundaryCondition is known
         std::string newStr;
-        stringCreator.writeMemoryAllocation(Img, width_str, height_str,
-            init_str, newStr);
+        if (!FusedDecls.count(VD) && !StreamedDecls.count(VD))
+          stringCreator.writeMemoryAllocation(Img, width_str, height_str,
+              init_str, newStr);
 
         // rewrite Image definition
         // get the start location and compute the semi location.
@@ -881,6 +953,19 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         assert((Img || Pyr) && "Expected first argument of BoundaryCondition "
                                "to be Image or Pyramid call.");
 
+        // allocate the ring buffer of a streamed kernel chain, holding as many
+        // rows as the mask of the consumer
+        if (Img && StreamedDecls.count(Img->getDecl())) {
+          CXXConstructExpr *ImgCCE =
+            dyn_cast<CXXConstructExpr>(Img->getDecl()->getInit());
+          std::string newStr;
+          Img->setRingRows(BC->getSizeY());
+          stringCreator.writeMemoryAllocation(Img,
+              convertToString(ImgCCE->getArg(0)),
+              convertToString(ImgCCE->getArg(1)), "NULL", newStr);
+          TextRewriter.InsertTextBefore(Img->getDecl()->getLocStart(), newStr);
+        }
+
 
         // remove BoundaryCondition definition
         TextRewriter.RemoveText(D->getSourceRange());
@@ -980,7 +1065,8 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         Acc = new HipaccAccessor(VD, BC, mode, roi_args == 4);
 
         std::string newStr;
-        newStr = "HipaccAccessor " + Acc->getName() + "(" + parms + ");";
+        if (!FusedDecls.count(VD))
+          newStr = "HipaccAccessor " + Acc->getName() + "(" + parms + ");";
 
         // replace Accessor decl by variables for width/height and offsets
         // get the start location and compute the semi location.
@@ -1051,7 +1137,8 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
         ISDeclMap[VD] = IS; // store IterationSpace
 
         std::string newStr;
-        newStr = "HipaccAccessor " + IS->getName() + "(" + parms + ");";
+        if (!FusedDecls.count(VD))
+          newStr = "HipaccAccessor " + IS->getName() + "(" + parms + ");";
 
         // replace iteration space decl by variables for width/height, and
         // offset
@@ -1271,6 +1358,8 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
           HipaccKernelClass *KC = KernelClassDeclMap[RT->getDecl()];
           HipaccKernel *K = new HipaccKernel(Context, VD, KC, compilerOptions);
           KernelDeclMap[VD] = K;
+          if (StreamedDecls.count(VD) || StreamMap.count(VD))
+            K->setStreamed(true);
 
           // remove kernel declaration
           TextRewriter.RemoveText(D->getSourceRange());
@@ -1318,6 +1407,40 @@ bool Rewrite::VisitDeclStmt(DeclStmt *D) {
             }
           }
 
+          // Accessors written by the kernel are additional outputs, written
+          // only at the pixel of the iteration space, so that bands of rows
+          // executed in parallel never write the same pixel
+          for (auto img : imgFields) {
+            if (img == KC->getOutField() ||
+                !(KC->getMemAccess(img) & WRITE_ONLY))
+              continue;
+            HipaccAccessor *Acc = K->getImgFromMapping(img);
+            if (!Acc)
+              continue;
+            if (KC->getMemPattern(img) != NO_STRIDE ||
+                Acc->getBoundaryMode() != Boundary::UNDEFINED ||
+                Acc->getInterpolationMode() != Interpolate::NO) {
+              unsigned DiagIDOutput =
+                Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                    "Accessor '%0' written by kernel '%1' has to be written "
+                    "at the current pixel without boundary condition and "
+                    "interpolation.");
+              Diags.Report(VD->getLocation(), DiagIDOutput)
+                << Acc->getName() << KC->getName();
+            }
+          }
+
+          // inline the fused producer kernel into the consumer kernel
+          if (FusionMap.count(VD)) {
+            KernelFusion &fusion = FusionMap[VD];
+            CXXConstructExpr *ImgCCE =
+              dyn_cast<CXXConstructExpr>(fusion.image->getInit());
+            K->insertFusion(KC->getMembers()[fusion.arg].field,
+                KernelDeclMap[fusion.producer],
+                convertToString(ImgCCE->getArg(0)),
+                convertToString(ImgCCE->getArg(1)));
+          }
+
           // set kernel configuration
           setKernelConfiguration(KC, K);
 
@@ -1364,12 +1487,389 @@ bool Rewrite::VisitFunctionDecl(FunctionDecl *D) {
     assert(D->getBody() && "main function has no body.");
     assert(isa<CompoundStmt>(D->getBody()) && "CompoundStmt for main body expected.");
     mainFD = D;
+
+    if (compilerOptions.fuseKernels())
+      findFusibleKernels(dyn_cast<CompoundStmt>(D->getBody()));
+    if (compilerOptions.streamKernels())
+      findStreamableKernels(dyn_cast<CompoundStmt>(D->getBody()));
+    findScannedKernels(D->getBody());
   }
 
   return true;
 }
 
 
+// count references to variables and remember declarations within main
+void Rewrite::countReferences(ArrayRef<Stmt *> stmts,
+    llvm::DenseMap<ValueDecl *, unsigned> &refCount,
+    llvm::DenseMap<ValueDecl *, size_t> &declPos) {
+  std::function<void(Stmt *)> countRefs = [&] (Stmt *S) {
+    if (!S)
+      return;
+    if (auto DRE = dyn_cast<DeclRefExpr>(S))
+      refCount[DRE->getDecl()]++;
+    for (auto child : S->children())
+      countRefs(child);
+  };
+  for (size_t i=0; i<stmts.size(); ++i) {
+    countRefs(stmts[i]);
+    if (auto DS = dyn_cast<DeclStmt>(stmts[i]))
+      for (auto decl : DS->decls())
+        if (auto VD = dyn_cast<VarDecl>(decl))
+          declPos[VD] = i;
+  }
+}
+
+
+// find kernels whose output is scanned or whose reduction result is read
+void Rewrite::findScannedKernels(Stmt *S) {
+  if (!S)
+    return;
+  auto E = dyn_cast<CXXMemberCallExpr>(S);
+  if (E && E->getDirectCallee()) {
+    if (VarDecl *VD = getVarDecl(E->getImplicitObjectArgument())) {
+      if (E->getDirectCallee()->getNameAsString() == "scan")
+        ScannedDecls.insert(VD);
+      if (E->getDirectCallee()->getNameAsString() == "reduced_data")
+        ReducedDecls.insert(VD);
+    }
+  }
+  for (auto child : S->children())
+    findScannedKernels(child);
+}
+
+
+VarDecl *Rewrite::getVarDecl(Expr *E) {
+  if (auto DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenCasts()))
+    return dyn_cast<VarDecl>(DRE->getDecl());
+  return nullptr;
+}
+
+
+// DSL object constructed from exactly one other DSL object
+VarDecl *Rewrite::getSingleArg(VarDecl *VD) {
+  auto CCE = dyn_cast_or_null<CXXConstructExpr>(VD->getInit());
+  if (!CCE || !CCE->getNumArgs())
+    return nullptr;
+  for (size_t i=1, e=CCE->getNumArgs(); i!=e; ++i)
+    if (!isa<CXXDefaultArgExpr>(CCE->getArg(i)))
+      return nullptr;
+  return getVarDecl(CCE->getArg(0));
+}
+
+
+bool Rewrite::isOfClass(VarDecl *VD, CXXRecordDecl *RD) {
+  return VD && compilerClasses.isTypeOfTemplateClass(VD->getType(), RD);
+}
+
+
+// image read by an Accessor, either directly or via a BoundaryCondition
+VarDecl *Rewrite::getAccessorImage(VarDecl *Acc, VarDecl *&BC) {
+  BC = nullptr;
+  if (!isOfClass(Acc, compilerClasses.Accessor))
+    return nullptr;
+  VarDecl *VD = getSingleArg(Acc);
+  if (isOfClass(VD, compilerClasses.BoundaryCondition)) {
+    BC = VD;
+    auto CCE = dyn_cast<CXXConstructExpr>(BC->getInit());
+    VD = getVarDecl(CCE->getArg(0));
+  }
+  return isOfClass(VD, compilerClasses.Image) ? VD : nullptr;
+}
+
+
+bool Rewrite::getImageSize(VarDecl *Img, int64_t &width, int64_t &height) {
+  auto CCE = dyn_cast<CXXConstructExpr>(Img->getInit());
+  if (!CCE->getArg(0)->isEvaluatable(Context) ||
+      !CCE->getArg(1)->isEvaluatable(Context))
+    return false;
+  width = CCE->getArg(0)->EvaluateKnownConstInt(Context).getSExtValue();
+  height = CCE->getArg(1)->EvaluateKnownConstInt(Context).getSExtValue();
+  return true;
+}
+
+
+// kernel instance executed by the statement
+VarDecl *Rewrite::getExecutedKernel(Stmt *S) {
+  auto E = dyn_cast<CXXMemberCallExpr>(S);
+  if (!E || !E->getDirectCallee() ||
+      E->getDirectCallee()->getNameAsString() != "execute")
+    return nullptr;
+  auto VD = getVarDecl(E->getImplicitObjectArgument());
+  if (!VD || VD->getType()->getTypeClass() != Type::Record)
+    return nullptr;
+  auto RD = cast<RecordType>(VD->getType())->getDecl();
+  return KernelClassDeclMap.count(RD) ? VD : nullptr;
+}
+
+
+HipaccKernelClass *Rewrite::getKernelClass(VarDecl *VD) {
+  return KernelClassDeclMap[cast<RecordType>(VD->getType())->getDecl()];
+}
+
+
+// Find producer/consumer kernel pairs that can be fused (C/C++): a point
+// operator P writing an intermediate image that is read by the consumer kernel
+// C executed immediately afterwards, e.g.
+//   Image<float> TMP(w, h);
+//   IterationSpace<float> IsTMP(TMP);
+//   Accessor<float> AccTMP(BcTMP);   // BcTMP(TMP, ...) or directly TMP
+//   Producer P(IsTMP, ...); Consumer C(IsOUT, AccTMP, ...);
+//   P.execute(); C.execute();
+// The consumer recomputes the producer for each pixel it reads. Since this is
+// a purely syntactic analysis of main, the intermediate image and the objects
+// derived from it must not be referenced anywhere else.
+void Rewrite::findFusibleKernels(CompoundStmt *body) {
+  llvm::DenseMap<ValueDecl *, unsigned> refCount;
+  llvm::DenseMap<ValueDecl *, size_t> declPos;
+  SmallVector<Stmt *, 16> stmts(body->body_begin(), body->body_end());
+  countReferences(stmts, refCount, declPos);
+
+  std::function<bool(Stmt *)> hasReturn = [&] (Stmt *S) {
+    if (!S)
+      return false;
+    if (isa<ReturnStmt>(S))
+      return true;
+    for (auto child : S->children())
+      if (hasReturn(child))
+        return true;
+    return false;
+  };
+
+  for (size_t i=0; i+1<stmts.size(); ++i) {
+    VarDecl *P = getExecutedKernel(stmts[i]);
+    VarDecl *C = getExecutedKernel(stmts[i+1]);
+    if (!P || !C || P == C || FusionMap.count(P) || refCount[P] != 1 ||
+        !declPos.count(P) || !declPos.count(C) || declPos[P] > declPos[C])
+      continue;
+
+    HipaccKernelClass *KCP = getKernelClass(P);
+    HipaccKernelClass *KCC = getKernelClass(C);
+    if (KCP == KCC || KCP->getKernelType() != PointOperator ||
+        KCP->getReduceFunction() || !KCP->getMaskFields().empty() ||
+        KCP->hasAccessorOutputs() || KCC->hasAccessorOutputs() ||
+        hasReturn(KCP->getKernelFunction()->getBody()))
+      continue;
+
+    // producer: iteration space over the whole intermediate image, reading
+    // images of the same size through plain Accessors
+    auto CCEP = dyn_cast<CXXConstructExpr>(P->getInit());
+    auto CCEC = dyn_cast<CXXConstructExpr>(C->getInit());
+    VarDecl *IS = nullptr, *Img = nullptr;
+    SmallVector<VarDecl *, 4> inputs;
+    bool fusible = true;
+    for (size_t j=0, e=KCP->getMembers().size(); j!=e && fusible; ++j) {
+      VarDecl *VD = getVarDecl(CCEP->getArg(j)), *BC = nullptr;
+      switch (KCP->getMembers()[j].kind) {
+        case HipaccKernelClass::FieldKind::IterationSpace:
+          IS = VD;
+          Img = IS ? getSingleArg(IS) : nullptr;
+          fusible = isOfClass(Img, compilerClasses.Image) && refCount[IS] == 1;
+          break;
+        case HipaccKernelClass::FieldKind::Image:
+          if (auto input = VD ? getAccessorImage(VD, BC) : nullptr)
+            inputs.push_back(input);
+          else
+            fusible = false;
+          break;
+        default:
+          break;
+      }
+    }
+    if (!fusible || !Img || refCount[Img] != 2)
+      continue;
+    int64_t width, height;
+    if (!getImageSize(Img, width, height))
+      continue;
+    for (auto input : inputs) {
+      int64_t input_width, input_height;
+      if (input == Img || !getImageSize(input, input_width, input_height) ||
+          input_width != width || input_height != height)
+        fusible = false;
+    }
+
+    // consumer: reads the intermediate image through exactly one Accessor
+    // and writes an image not read by the producer
+    size_t arg = 0, num_reads = 0;
+    VarDecl *Acc = nullptr, *AccBC = nullptr;
+    for (size_t j=0, e=KCC->getMembers().size(); j!=e && fusible; ++j) {
+      VarDecl *VD = getVarDecl(CCEC->getArg(j)), *BC = nullptr;
+      switch (KCC->getMembers()[j].kind) {
+        case HipaccKernelClass::FieldKind::IterationSpace:
+          if (!VD || !getSingleArg(VD) ||
+              std::find(inputs.begin(), inputs.end(), getSingleArg(VD)) !=
+              inputs.end())
+            fusible = false;
+          break;
+        case HipaccKernelClass::FieldKind::Image:
+          if (VD && getAccessorImage(VD, BC) == Img) {
+            arg = j;
+            Acc = VD;
+            AccBC = BC;
+            num_reads++;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    if (!fusible || num_reads != 1 || refCount[Acc] != 1 || (AccBC && refCount[AccBC] != 1))
+      continue;
+
+    KernelFusion fusion = { P, Img, arg };
+    FusionMap[C] = fusion;
+    FusedDecls.insert(P);
+    FusedDecls.insert(Img);
+    FusedDecls.insert(IS);
+    FusedDecls.insert(Acc);
+    if (AccBC)
+      FusedDecls.insert(AccBC);
+  }
+}
+
+
+// Find chains of kernels that can be executed row by row (C/C++): each stage
+// writes an intermediate image that is read only by the next stage through a
+// BoundaryCondition, and the stages are executed one after another, e.g.
+//   Image<float> TMP(w, h);
+//   IterationSpace<float> IsTMP(TMP);
+//   BoundaryCondition<float> BcTMP(TMP, M, Boundary::MIRROR);
+//   Accessor<float> AccTMP(BcTMP);
+//   Sobel S(IsTMP, AccIN, M); Harris H(IsOUT, AccTMP, M);
+//   S.execute(); H.execute();
+// The intermediate image is replaced by a ring buffer holding as many rows as
+// the mask of the BoundaryCondition. Boundary::REPEAT reads rows from the
+// other end of the image and prevents streaming.
+void Rewrite::findStreamableKernels(CompoundStmt *body) {
+  llvm::DenseMap<ValueDecl *, unsigned> refCount;
+  llvm::DenseMap<ValueDecl *, size_t> declPos;
+  SmallVector<Stmt *, 16> stmts(body->body_begin(), body->body_end());
+  countReferences(stmts, refCount, declPos);
+
+  auto getOutputImage = [&] (VarDecl *K) -> VarDecl * {
+    auto CCE = dyn_cast<CXXConstructExpr>(K->getInit());
+    auto KC = getKernelClass(K);
+    for (size_t j=0, e=KC->getMembers().size(); j!=e; ++j) {
+      if (KC->getMembers()[j].kind ==
+          HipaccKernelClass::FieldKind::IterationSpace) {
+        VarDecl *IS = getVarDecl(CCE->getArg(j));
+        VarDecl *Img = IS ? getSingleArg(IS) : nullptr;
+        return isOfClass(Img, compilerClasses.Image) && refCount[IS] == 1 ?
+          Img : nullptr;
+      }
+    }
+    return nullptr;
+  };
+  // images read by a kernel; fails for pyramids and other Accessors
+  auto getInputImages = [&] (VarDecl *K, SmallVectorImpl<VarDecl *> &images,
+                             SmallVectorImpl<VarDecl *> &accessors) {
+    auto CCE = dyn_cast<CXXConstructExpr>(K->getInit());
+    auto KC = getKernelClass(K);
+    for (size_t j=0, e=KC->getMembers().size(); j!=e; ++j) {
+      if (KC->getMembers()[j].kind == HipaccKernelClass::FieldKind::Image) {
+        VarDecl *Acc = getVarDecl(CCE->getArg(j)), *BC = nullptr;
+        VarDecl *Img = Acc ? getAccessorImage(Acc, BC) : nullptr;
+        if (!Img)
+          return false;
+        images.push_back(Img);
+        accessors.push_back(Acc);
+      }
+    }
+    return true;
+  };
+  auto isStreamable = [&] (VarDecl *K) {
+    if (!K || refCount[K] != 1 || !declPos.count(K) || FusionMap.count(K) ||
+        FusedDecls.count(K))
+      return false;
+    auto KC = getKernelClass(K);
+    return KC->getKernelType() != UserOperator && !KC->getReduceFunction() &&
+           !KC->hasAccessorOutputs() && getOutputImage(K);
+  };
+  auto isRepeatMode = [&] (VarDecl *BC) {
+    auto CCE = dyn_cast<CXXConstructExpr>(BC->getInit());
+    for (auto arg : CCE->arguments()) {
+      auto DRE = dyn_cast<DeclRefExpr>(arg->IgnoreParenCasts());
+      if (DRE && DRE->getDecl()->getKind() == Decl::EnumConstant &&
+          DRE->getDecl()->getType().getAsString() == "enum hipacc::Boundary")
+        return arg->EvaluateKnownConstInt(Context).getZExtValue() ==
+          static_cast<std::underlying_type<Boundary>::type>(Boundary::REPEAT);
+    }
+    return false;
+  };
+
+  for (size_t i=0; i<stmts.size(); ++i) {
+    VarDecl *K = getExecutedKernel(stmts[i]);
+    int64_t width, height;
+    if (!isStreamable(K) || !getImageSize(getOutputImage(K), width, height))
+      continue;
+
+    // extend the chain while the next statement executes a kernel reading the
+    // output of the last stage
+    KernelStream stream;
+    SmallVector<VarDecl *, 4> outputs, inputs, reads;
+    if (!getInputImages(K, inputs, reads))
+      continue;
+    stream.stages.push_back(K);
+    stream.accessors.push_back(nullptr);
+    outputs.push_back(getOutputImage(K));
+    for (size_t j=i+1; j<stmts.size(); ++j) {
+      VarDecl *P = stream.stages.back();
+      VarDecl *C = getExecutedKernel(stmts[j]);
+      VarDecl *Img = outputs.back();
+      int64_t img_width, img_height;
+      if (!isStreamable(C) || refCount[Img] != 2 ||
+          !getImageSize(getOutputImage(C), img_width, img_height) ||
+          img_width != width || img_height != height)
+        break;
+
+      // exactly one Accessor of the consumer reads the intermediate image
+      SmallVector<VarDecl *, 4> images, accessors;
+      if (!getInputImages(C, images, accessors))
+        break;
+      VarDecl *Acc = nullptr, *BC = nullptr;
+      for (size_t k=0; k<images.size(); ++k)
+        if (images[k] == Img)
+          Acc = accessors[k];
+      if (!Acc || refCount[Acc] != 1)
+        break;
+      getAccessorImage(Acc, BC);
+      // the size of the ring buffer has to be known when the producer is
+      // translated
+      if (!BC || refCount[BC] != 1 || isRepeatMode(BC) ||
+          !declPos.count(BC) || declPos[BC] > declPos[P])
+        break;
+
+      stream.stages.push_back(C);
+      stream.accessors.push_back(Acc);
+      outputs.push_back(getOutputImage(C));
+      for (auto image : images)
+        if (image != Img)
+          inputs.push_back(image);
+    }
+    if (stream.stages.size() < 2)
+      continue;
+
+    // images written by the chain must not be read by other stages
+    bool streamable = true;
+    for (auto input : inputs)
+      if (std::find(outputs.begin(), outputs.end(), input) != outputs.end())
+        streamable = false;
+    for (size_t k=0; k<outputs.size(); ++k)
+      if (std::count(outputs.begin(), outputs.end(), outputs[k]) != 1)
+        streamable = false;
+    if (!streamable)
+      continue;
+
+    for (size_t k=0; k+1<stream.stages.size(); ++k) {
+      StreamedDecls.insert(stream.stages[k]);
+      StreamedDecls.insert(outputs[k]);
+    }
+    StreamMap[stream.stages.back()] = stream;
+    i += stream.stages.size() - 1;
+  }
+}
+
+
 bool Rewrite::VisitCXXOperatorCallExpr(CXXOperatorCallExpr *E) {
   if (!compilerClasses.HipaccEoP)
     return true;
@@ -1632,6 +2132,42 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
         VarDecl *VD = K->getDecl();
         std::string newStr;
 
+        // fused producer kernels are computed by their consumer kernel;
+        // streamed kernel chains are executed at their last stage
+        if (FusedDecls.count(VD) || StreamedDecls.count(VD)) {
+          SourceLocation startLoc = E->getLocStart();
+          const char *startBuf = SM.getCharacterData(startLoc);
+          const char *semiPtr = strchr(startBuf, ';');
+          TextRewriter.RemoveText(startLoc, semiPtr-startBuf+1,
+              TextRewriteOptions);
+          return true;
+        }
+
+        // execute all stages of a streamed kernel chain row by row; each
+        // stage lags behind its producer by the radius of the mask it reads
+        if (StreamMap.count(VD)) {
+          KernelStream &stream = StreamMap[VD];
+          SmallVector<HipaccKernel *, 4> stages;
+          SmallVector<unsigned, 4> lags;
+          for (size_t i=0; i<stream.stages.size(); ++i) {
+            HipaccKernel *S = KernelDeclMap[stream.stages[i]];
+            CXXConstructExpr *CCE =
+              dyn_cast<CXXConstructExpr>(stream.stages[i]->getInit());
+            S->setHostArgNames(llvm::makeArrayRef(CCE->getArgs(),
+                  CCE->getNumArgs()), newStr, literalCount);
+            stages.push_back(S);
+            lags.push_back(i ? lags.back() +
+                AccDeclMap[stream.accessors[i]]->getSizeY()/2 : 0);
+          }
+          stringCreator.writeStreamCall(stages, lags, newStr);
+
+          SourceLocation startLoc = E->getLocStart();
+          const char *startBuf = SM.getCharacterData(startLoc);
+          const char *semiPtr = strchr(startBuf, ';');
+          TextRewriter.ReplaceText(startLoc, semiPtr-startBuf+1, newStr);
+          return true;
+        }
+
         // this was checked before, when the user class was parsed
         CXXConstructExpr *CCE = dyn_cast<CXXConstructExpr>(VD->getInit());
         assert(CCE->getNumArgs() == K->getKernelClass()->getMembers().size() &&
@@ -1647,8 +2183,13 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
         // create kernel call string
         stringCreator.writeKernelCall(K, newStr);
 
-        // create reduce call string
-        if (K->getKernelClass()->getReduceFunction()) {
+        // create reduce call string; bins are computed by binned_data(), and
+        // kernels for scan() are reduced only for reduced_data()
+        if (K->getKernelClass()->getBinningFunction()) {
+          newStr += "\n" + stringCreator.getIndent();
+          stringCreator.writeBinningDeclaration(K, newStr);
+        } else if (K->getKernelClass()->getReduceFunction() &&
+                   (!ScannedDecls.count(VD) || ReducedDecls.count(VD))) {
           newStr += "\n" + stringCreator.getIndent();
           stringCreator.writeReductionDeclaration(K, newStr);
           stringCreator.writeReduceCall(K, newStr);
@@ -1682,6 +2223,51 @@ bool Rewrite::VisitCXXMemberCallExpr(CXXMemberCallExpr *E) {
           SourceRange range(E->getLocStart(), E->getLocEnd());
           TextRewriter.ReplaceText(range, K->getReduceStr());
 
+          return true;
+        }
+        if (ME->getMemberNameInfo().getAsString() == "binned_data") {
+          HipaccKernel *K = KernelDeclMap[DRE->getDecl()];
+
+          // replace member function invocation by the binning
+          SourceRange range(E->getLocStart(), E->getLocEnd());
+          stringCreator.writeBinningCall(K, convertToString(E->getArg(0)),
+              getHistogramWeight(K->getKernelClass()), newStr);
+          TextRewriter.ReplaceText(range, newStr);
+
+          return true;
+        }
+        if (ME->getMemberNameInfo().getAsString() == "scan") {
+          HipaccKernel *K = KernelDeclMap[DRE->getDecl()];
+          if (!compilerOptions.emitC99()) {
+            unsigned IDScan = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                "Scan of kernel %0 is only supported for C/C++.");
+            Diags.Report(E->getExprLoc(), IDScan)
+              << K->getKernelClass()->getName();
+            exit(EXIT_FAILURE);
+          }
+          if (!K->getKernelClass()->getReduceFunction()) {
+            unsigned IDReduce = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                "Scan of kernel %0 requires a reduce function to combine "
+                "pixels.");
+            Diags.Report(E->getExprLoc(), IDReduce)
+              << K->getKernelClass()->getName();
+            exit(EXIT_FAILURE);
+          }
+          llvm::APSInt mode;
+          if (!E->getArg(0)->EvaluateAsInt(mode, Context)) {
+            unsigned IDMode = Diags.getCustomDiagID(DiagnosticsEngine::Error,
+                "Scan direction of kernel %0 has to be a constant.");
+            Diags.Report(E->getArg(0)->getExprLoc(), IDMode)
+              << K->getKernelClass()->getName();
+            exit(EXIT_FAILURE);
+          }
+
+          // replace member function invocation by the scan of the output
+          SourceRange range(E->getLocStart(), E->getLocEnd());
+          stringCreator.writeScanCall(K, static_cast<Scan>(
+                mode.getZExtValue()), newStr);
+          TextRewriter.ReplaceText(range, newStr);
+
           return true;
         }
       }
@@ -1884,12 +2470,13 @@ void Rewrite::printReductionFunction(HipaccKernelClass *KC, HipaccKernel *K,
     llvm::raw_fd_ostream &OS) {
   FunctionDecl *fun = KC->getReduceFunction();
 
-  // preprocessor defines
-  if (!compilerOptions.exploreConfig()) {
+  // preprocessor defines; the C/C++ runtime takes the offsets from the
+  // iteration space accessor
+  if (!compilerOptions.exploreConfig() && !compilerOptions.emitC99()) {
     OS << "#define BS " << K->getNumThreadsReduce() << "\n"
        << "#define PPT " << K->getPixelsPerThreadReduce() << "\n";
   }
-  if (K->getIterationSpace()->isCrop()) {
+  if (K->getIterationSpace()->isCrop() && !compilerOptions.emitC99()) {
     OS << "#define USE_OFFSETS\n";
   }
   switch (compilerOptions.getTargetLang()) {
@@ -2391,6 +2978,14 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
             OS << ", ";
           if (mem_acc == READ_ONLY)
             OS << "const ";
+          if (K->vectorize() || K->getPixelsPerThread() > 1) {
+            // restrict allows the host compiler to vectorize the lane loops
+            // and to share loads between the rows computed per iteration
+            OS << Acc->getImage()->getTypeStr()
+               << " (* __restrict__ " << Name << ")"
+               << "[" << Acc->getImage()->getSizeXStr() << "]";
+            break;
+          }
           OS << Acc->getImage()->getTypeStr()
              << " " << Name
              << "[" << Acc->getImage()->getSizeYStr() << "]"
@@ -2463,6 +3058,8 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
 
   if (KC->getReduceFunction())
     printReductionFunction(KC, K, OS);
+  if (KC->getBinningFunction())
+    printBinningFunction(KC, K, OS);
 
   OS << "#endif //" + ifdef + "\n";
   OS << "\n";
@@ -2471,5 +3068,81 @@ void Rewrite::printKernelFunction(FunctionDecl *D, HipaccKernelClass *KC,
   close(fd);
 }
 
+// check if the binning function computes a histogram of 8-bit pixels:
+// 'bin(pixel) = weight;' for a constant weight, combined by
+// 'return left + right;'. Returns the weight, or an empty string.
+std::string Rewrite::getHistogramWeight(HipaccKernelClass *KC) {
+  CXXMethodDecl *binning = KC->getBinningFunction();
+  CXXMethodDecl *reduce = KC->getReduceFunction();
+  if (binning->getNumParams() != 3 || reduce->getNumParams() != 2 ||
+      !binning->getParamDecl(2)->getType()->isSpecificBuiltinType(
+        BuiltinType::UChar))
+    return "";
+
+  auto getSingleStmt = [] (CXXMethodDecl *fun) -> Stmt * {
+    CompoundStmt *body = dyn_cast_or_null<CompoundStmt>(fun->getBody());
+    return body && body->size() == 1 ? body->body_front() : nullptr;
+  };
+  auto isParam = [] (Expr *E, ParmVarDecl *param) -> bool {
+    DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts());
+    return DRE && DRE->getDecl() == param;
+  };
+
+  // return left + right;
+  ReturnStmt *ret = dyn_cast_or_null<ReturnStmt>(getSingleStmt(reduce));
+  BinaryOperator *add = ret && ret->getRetValue() ? dyn_cast<BinaryOperator>(
+      ret->getRetValue()->IgnoreParenImpCasts()) : nullptr;
+  if (!add || add->getOpcode() != BO_Add ||
+      !((isParam(add->getLHS(), reduce->getParamDecl(0)) &&
+         isParam(add->getRHS(), reduce->getParamDecl(1))) ||
+        (isParam(add->getLHS(), reduce->getParamDecl(1)) &&
+         isParam(add->getRHS(), reduce->getParamDecl(0)))))
+    return "";
+
+  // bin(pixel) = weight;
+  Expr *E = dyn_cast_or_null<Expr>(getSingleStmt(binning));
+  CXXOperatorCallExpr *assign = E ? dyn_cast<CXXOperatorCallExpr>(
+      E->IgnoreImplicit()) : nullptr;
+  if (!assign || assign->getOperator() != OO_Equal ||
+      assign->getNumArgs() != 2)
+    return "";
+  CXXMemberCallExpr *bin = dyn_cast<CXXMemberCallExpr>(
+      assign->getArg(0)->IgnoreImplicit());
+  if (!bin || !bin->getDirectCallee() ||
+      bin->getDirectCallee()->getNameAsString() != "bin" ||
+      bin->getNumArgs() != 1 ||
+      !isParam(bin->getArg(0), binning->getParamDecl(2)) ||
+      !assign->getArg(1)->isEvaluatable(Context))
+    return "";
+
+  return convertToString(assign->getArg(1));
+}
+
+
+// print the binning function as functor for the C/C++ runtime
+void Rewrite::printBinningFunction(HipaccKernelClass *KC, HipaccKernel *K,
+    llvm::raw_fd_ostream &OS) {
+  FunctionDecl *fun = KC->getBinningFunction();
+  std::string bin_type(KC->getReduceFunction()->getReturnType().getAsString());
+
+  OS << "struct " << K->getBinningName() << " : HipaccBinning<" << bin_type
+     << ", " << K->getReduceName() << "> {\n";
+  OS << "  inline void operator()(";
+  size_t comma = 0;
+  for (auto param : fun->parameters()) {
+    std::string Name(param->getNameAsString());
+    QualType T = param->getOriginalType();
+    if (comma++)
+      OS << ", ";
+    T.getAsStringInternal(Name, Policy);
+    OS << Name;
+  }
+  OS << ") ";
+
+  // print binning body
+  fun->getBody()->printPretty(OS, 0, Policy, 1);
+  OS << "\n};\n\n";
+}
+
 // vim: set ts=2 sw=2 sts=2 et ai:
 
@@ -27,14 +27,24 @@
 #define __HIPACC_BASE_HPP__
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 #include "hipacc_math_functions.hpp"
+#include "hipacc_trace.hpp"
 
 #define HIPACC_NUM_ITERATIONS 10
 
@@ -72,23 +82,32 @@ class HipaccImage {
         void *mem;
         hipaccMemoryType mem_type;
         char *host;
-        uint32_t *refcount;
+        bool own_host;
+        std::atomic<uint32_t> *refcount;
 
     public:
         HipaccImage(size_t width, size_t height, size_t stride,
                     size_t alignment, size_t pixel_size, void *mem,
                     hipaccMemoryType mem_type=Global) :
+            HipaccImage(width, height, stride, alignment, pixel_size, mem,
+                        mem_type, new char[width*height*pixel_size](), true)
+        {}
+
+        // host memory provided by the runtime; it may alias the image memory
+        // if both have the same layout, in which case it is not owned
+        HipaccImage(size_t width, size_t height, size_t stride,
+                    size_t alignment, size_t pixel_size, void *mem,
+                    hipaccMemoryType mem_type, char *host, bool own_host) :
             width(width), height(height),
             stride(stride),
             alignment(alignment),
             pixel_size(pixel_size),
             mem(mem),
             mem_type(mem_type),
-            host(new char[width*height*pixel_size]),
-            refcount(new uint32_t(1))
-        {
-            std::fill(host, host + width*height*pixel_size, 0);
-        }
+            host(host),
+            own_host(own_host),
+            refcount(new std::atomic<uint32_t>(1))
+        {}
 
         HipaccImage(const HipaccImage &image) :
             width(image.width),
@@ -99,22 +118,36 @@ class HipaccImage {
             mem(image.mem),
             mem_type(image.mem_type),
             host(image.host),
+            own_host(image.own_host),
             refcount(image.refcount)
         {
             ++(*refcount);
         }
 
+        HipaccImage &operator=(HipaccImage image) {
+            std::swap(width, image.width);
+            std::swap(height, image.height);
+            std::swap(stride, image.stride);
+            std::swap(alignment, image.alignment);
+            std::swap(pixel_size, image.pixel_size);
+            std::swap(mem, image.mem);
+            std::swap(mem_type, image.mem_type);
+            std::swap(host, image.host);
+            std::swap(own_host, image.own_host);
+            std::swap(refcount, image.refcount);
+            return *this;
+        }
+
         ~HipaccImage() {
-            --(*refcount);
-            if (host != NULL &&
-                *refcount == 0) {
+            if (--(*refcount) == 0) {
               delete refcount;
-              delete[] host;
+              if (own_host)
+                delete[] host;
               host = NULL;
             }
         }
 
-        bool operator==(HipaccImage other) const {
+        bool operator==(const HipaccImage &other) const {
             return mem==other.mem;
         }
 };
@@ -142,17 +175,161 @@ class HipaccAccessor {
 };
 
 
+typedef struct hipacc_pool_stats {
+    size_t bytes_in_use, bytes_cached;
+    size_t high_water_mark;
+    size_t num_allocs, num_reuses;
+} hipacc_pool_stats;
+
+
+// Pool of host memory buffers. Released buffers are cached and handed out
+// again for the same pixel size, stride, height, and alignment. Buffers are
+// aligned to 64 bytes, large buffers to pages and advised to use huge pages.
+class HipaccMemoryPool {
+    private:
+        typedef std::tuple<size_t, size_t, size_t, size_t> pool_key;
+
+        enum : size_t {
+            line_size = 64,
+            page_size = 4096,
+            huge_size = 2 << 20
+        };
+
+        std::map<pool_key, std::vector<void *>> free_bufs;
+        std::map<void *, pool_key> used_bufs;
+        std::mutex mutex;
+        size_t max_cached;
+        hipacc_pool_stats stats_;
+
+        static size_t bytes(const pool_key &key) {
+            return std::get<0>(key) * std::get<1>(key) * std::get<2>(key);
+        }
+
+        // the unaligned pointer is stored in front of the aligned buffer
+        static void *alloc_aligned(size_t size, size_t align) {
+            char *base = (char *)std::malloc(size + align + sizeof(void *));
+            if (base == NULL) return NULL;
+            uintptr_t addr = (uintptr_t)(base + sizeof(void *));
+            void *mem = (void *)((addr + align - 1) & ~(uintptr_t)(align - 1));
+            ((void **)mem)[-1] = base;
+            #if defined(__linux__) && defined(MADV_HUGEPAGE)
+            if (size >= huge_size)
+                madvise(mem, size & ~(page_size - 1), MADV_HUGEPAGE);
+            #endif
+            return mem;
+        }
+
+        static void free_aligned(void *mem) {
+            std::free(((void **)mem)[-1]);
+        }
+
+        HipaccMemoryPool(HipaccMemoryPool const &);
+        void operator=(HipaccMemoryPool const &);
+
+    public:
+        HipaccMemoryPool(size_t max_cached=size_t(256) << 20) :
+            max_cached(max_cached), stats_() {}
+
+        ~HipaccMemoryPool() {
+            trim();
+            for (auto &buf : used_bufs)
+                free_aligned(buf.first);
+        }
+
+        // alignment requests beyond a page are served with page alignment
+        void *alloc(size_t pixel_size, size_t stride, size_t height,
+                    size_t alignment=0) {
+            size_t size = pixel_size * stride * height;
+            size_t align = size >= huge_size ? page_size : line_size;
+            while (align < alignment && align < page_size)
+                align *= 2;
+            pool_key key(pixel_size, stride, height, align);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            void *mem = NULL;
+            auto iter = free_bufs.find(key);
+            if (iter != free_bufs.end() && !iter->second.empty()) {
+                mem = iter->second.back();
+                iter->second.pop_back();
+                stats_.bytes_cached -= size;
+                ++stats_.num_reuses;
+            } else {
+                mem = alloc_aligned(size, align);
+                if (mem == NULL) return NULL;
+                ++stats_.num_allocs;
+            }
+            used_bufs[mem] = key;
+            stats_.bytes_in_use += size;
+            stats_.high_water_mark = std::max(stats_.high_water_mark,
+                    stats_.bytes_in_use + stats_.bytes_cached);
+
+            return mem;
+        }
+
+        // returns false for memory not allocated by the pool
+        bool release(void *mem) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto iter = used_bufs.find(mem);
+            if (iter == used_bufs.end()) return false;
+
+            pool_key key = iter->second;
+            size_t size = bytes(key);
+            used_bufs.erase(iter);
+            stats_.bytes_in_use -= size;
+            if (stats_.bytes_cached + size > max_cached) {
+                free_aligned(mem);
+            } else {
+                free_bufs[key].push_back(mem);
+                stats_.bytes_cached += size;
+            }
+
+            return true;
+        }
+
+        // free all cached buffers
+        void trim() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &bufs : free_bufs)
+                for (auto mem : bufs.second)
+                    free_aligned(mem);
+            free_bufs.clear();
+            stats_.bytes_cached = 0;
+        }
+
+        void set_max_cached(size_t bytes) {
+            max_cached = bytes;
+            if (stats_.bytes_cached > max_cached)
+                trim();
+        }
+
+        hipacc_pool_stats stats() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return stats_;
+        }
+};
+
+
 class HipaccContextBase {
     protected:
         std::list<HipaccImage> imgs;
+        std::mutex imgs_mutex;
+        HipaccMemoryPool mem_pool;
+        // levels of released pyramids, kept for the next pyramid of the same
+        // base image geometry and depth
+        std::list<std::vector<HipaccImage>> free_pyramids;
+        std::mutex pyramid_mutex;
 
         HipaccContextBase() {};
         HipaccContextBase(HipaccContextBase const &);
         void operator=(HipaccContextBase const &);
 
     public:
-        void add_image(HipaccImage &img) { imgs.push_back(img); }
+        void add_image(HipaccImage &img) {
+            std::lock_guard<std::mutex> lock(imgs_mutex);
+            imgs.push_back(img);
+        }
         void del_image(HipaccImage &img) {
+            std::lock_guard<std::mutex> lock(imgs_mutex);
             for (auto &iter : imgs) {
                 if (iter == img) {
                     imgs.remove(iter);
@@ -160,6 +337,43 @@ class HipaccContextBase {
                 }
             }
         }
+        HipaccMemoryPool &get_pool() { return mem_pool; }
+
+        // allocate levels 1 to depth-1 of a pyramid; runtimes may hide this
+        // function to allocate all levels at once
+        template<typename T>
+        static void create_pyramid_levels(std::vector<HipaccImage> &levels,
+                                          HipaccImage &base, size_t depth);
+
+        bool take_pyramid(std::vector<HipaccImage> &levels, HipaccImage &base,
+                          size_t depth) {
+            std::lock_guard<std::mutex> lock(pyramid_mutex);
+            for (auto iter = free_pyramids.begin(); iter != free_pyramids.end(); ++iter) {
+                HipaccImage &level = iter->front();
+                if (iter->size() == depth &&
+                    level.width == base.width && level.height == base.height &&
+                    level.alignment == base.alignment &&
+                    level.pixel_size == base.pixel_size &&
+                    level.mem_type == base.mem_type) {
+                    levels.swap(*iter);
+                    levels.front() = base;
+                    free_pyramids.erase(iter);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // returns false if the levels have to be released
+        bool park_pyramid(std::vector<HipaccImage> &levels) {
+            static const size_t max_free_pyramids = 8;
+            std::lock_guard<std::mutex> lock(pyramid_mutex);
+            if (free_pyramids.size() >= max_free_pyramids)
+                return false;
+            free_pyramids.emplace_back();
+            free_pyramids.back().swap(levels);
+            return true;
+        }
 };
 
 
@@ -214,6 +428,8 @@ unsigned int nextPow2(unsigned int x) {
 #endif // EXCLUDE_IMPL
 
 
+class HipaccContext;
+
 class HipaccPyramid {
   public:
     const int depth_;
@@ -230,6 +446,14 @@ class HipaccPyramid {
         imgs_.push_back(img);
     }
 
+    // use the pyramid for a new base image of the same size, e.g. the next
+    // frame of a video; the levels are kept
+    void rebind(HipaccImage &base) {
+        assert(base.width == imgs_[0].width && base.height == imgs_[0].height &&
+               "Pyramid rebound to image of different size.");
+        imgs_[0] = base;
+    }
+
     HipaccImage &operator()(int relative) {
         assert(level_ + relative >= 0 && level_ + relative < (int)imgs_.size() &&
                "Accessed pyramid stage is out of bounds.");
@@ -253,9 +477,7 @@ class HipaccPyramid {
     }
 
     void swap(HipaccPyramid &other) {
-        std::vector<HipaccImage> tmp = other.imgs_;
-        other.imgs_ = this->imgs_;
-        this->imgs_ = tmp;
+        imgs_.swap(other.imgs_);
     }
 
     bool bind() {
@@ -280,25 +502,38 @@ HipaccImage hipaccCreatePyramidImage(HipaccImage &base, size_t width, size_t hei
 template<typename T>
 void hipaccReleaseMemory(HipaccImage &Img);
 
-template<typename data_t>
-HipaccPyramid hipaccCreatePyramid(HipaccImage &img, size_t depth) {
-    HipaccPyramid p(depth);
-    p.add(img);
-
-    size_t width  = img.width  / 2;
-    size_t height = img.height / 2;
+template<typename T>
+void HipaccContextBase::create_pyramid_levels(std::vector<HipaccImage> &levels,
+                                              HipaccImage &base, size_t depth) {
+    size_t width  = base.width  / 2;
+    size_t height = base.height / 2;
     for (size_t i=1; i<depth; ++i) {
         assert(width * height > 0 && "Pyramid stages too deep for image size");
-        p.add(hipaccCreatePyramidImage<data_t>(img, width, height));
+        levels.push_back(hipaccCreatePyramidImage<T>(base, width, height));
         width  /= 2;
         height /= 2;
     }
+}
+
+
+// the levels of released pyramids are reused for pyramids of the same base
+// image geometry and depth
+template<typename data_t, typename Context=HipaccContext>
+HipaccPyramid hipaccCreatePyramid(HipaccImage &img, size_t depth) {
+    HipaccPyramid p(depth);
+    Context &Ctx = Context::getInstance();
+    if (!Ctx.take_pyramid(p.imgs_, img, depth)) {
+        p.add(img);
+        Context::template create_pyramid_levels<data_t>(p.imgs_, img, depth);
+    }
     return p;
 }
 
 
-template<typename T>
+template<typename T, typename Context=HipaccContext>
 void hipaccReleasePyramid(HipaccPyramid &pyr) {
+    if (Context::getInstance().park_pyramid(pyr.imgs_))
+        return;
     // Do not remove the first one, it was created outside this context
     while (pyr.imgs_.size() > 1) {
         hipaccReleaseMemory<T>(pyr.imgs_.back());
@@ -309,193 +544,97 @@ void hipaccReleasePyramid(HipaccPyramid &pyr) {
 
 #ifndef EXCLUDE_IMPL
 
-std::vector<const std::function<void()>*> hipaccTraverseFunc;
-std::vector<std::vector<HipaccPyramid*>>  hipaccPyramids;
-
+void hipaccRebindPyramid(HipaccPyramid &pyr, HipaccImage &img) {
+    pyr.rebind(img);
+}
 
-void hipaccTraverse(HipaccPyramid &p0, const std::function<void()> func) {
-    assert(p0.bind() && "Pyramid already bound to another traversal.");
 
+// stack of active traversals of the calling thread; each thread may traverse
+// its own pyramids
+struct hipacc_traversal {
+    const std::function<void()> *func;
     std::vector<HipaccPyramid*> pyrs;
-    pyrs.push_back(&p0);
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
-
-    (*hipaccTraverseFunc.back())();
-
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
+};
 
-    p0.unbind();
+std::vector<hipacc_traversal> &hipaccTraversals() {
+    static thread_local std::vector<hipacc_traversal> traversals;
+    return traversals;
 }
 
 
-void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1,
-                    const std::function<void()> func) {
-    assert(p0.depth_ == p1.depth_ &&
-           "Pyramid depths do not match.");
-
-    assert(p0.bind() && "Pyramid already bound to another traversal.");
-    assert(p1.bind() && "Pyramid already bound to another traversal.");
-
-    std::vector<HipaccPyramid*> pyrs;
-    pyrs.push_back(&p0);
-    pyrs.push_back(&p1);
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
+void hipaccTraverse(std::vector<HipaccPyramid*> pyrs,
+                    const std::function<void()> &func) {
+    for (size_t i=0; i<pyrs.size(); ++i) {
+        if (i < pyrs.size() - 1) {
+            assert(pyrs[i]->depth_ == pyrs[i+1]->depth_ && "Pyramid depths do not match.");
+        }
+        bool bound = pyrs[i]->bind();
+        assert(bound && "Pyramid already bound to another traversal.");
+        (void)bound;
+    }
 
-    (*hipaccTraverseFunc.back())();
+    std::vector<hipacc_traversal> &traversals = hipaccTraversals();
+    traversals.push_back(hipacc_traversal());
+    traversals.back().func = &func;
+    traversals.back().pyrs.swap(pyrs);
 
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
+    func();
 
-    p0.unbind();
-    p1.unbind();
+    for (auto pyr : traversals.back().pyrs)
+        pyr->unbind();
+    traversals.pop_back();
 }
 
 
-void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
-                    const std::function<void()> func) {
-    assert(p0.depth_ == p1.depth_ &&
-           p1.depth_ == p2.depth_ &&
-           "Pyramid depths do not match.");
-
-    assert(p0.bind() && "Pyramid already bound to another traversal.");
-    assert(p1.bind() && "Pyramid already bound to another traversal.");
-    assert(p2.bind() && "Pyramid already bound to another traversal.");
-
-    std::vector<HipaccPyramid*> pyrs;
-    pyrs.push_back(&p0);
-    pyrs.push_back(&p1);
-    pyrs.push_back(&p2);
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
-
-    (*hipaccTraverseFunc.back())();
+void hipaccTraverse(HipaccPyramid &p0, const std::function<void()> &func) {
+    hipaccTraverse(std::vector<HipaccPyramid*>{ &p0 }, func);
+}
 
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
 
-    p0.unbind();
-    p1.unbind();
-    p2.unbind();
+void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1,
+                    const std::function<void()> &func) {
+    hipaccTraverse(std::vector<HipaccPyramid*>{ &p0, &p1 }, func);
 }
 
 
 void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
-                    HipaccPyramid &p3, const std::function<void()> func) {
-    assert(p0.depth_ == p1.depth_ &&
-           p1.depth_ == p2.depth_ &&
-           p2.depth_ == p3.depth_ &&
-           "Pyramid depths do not match.");
-
-    assert(p0.bind() && "Pyramid already bound to another traversal.");
-    assert(p1.bind() && "Pyramid already bound to another traversal.");
-    assert(p2.bind() && "Pyramid already bound to another traversal.");
-    assert(p3.bind() && "Pyramid already bound to another traversal.");
-
-    std::vector<HipaccPyramid*> pyrs;
-    pyrs.push_back(&p0);
-    pyrs.push_back(&p1);
-    pyrs.push_back(&p2);
-    pyrs.push_back(&p3);
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
-
-    (*hipaccTraverseFunc.back())();
-
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
-
-    p0.unbind();
-    p1.unbind();
-    p2.unbind();
-    p3.unbind();
+                    const std::function<void()> &func) {
+    hipaccTraverse(std::vector<HipaccPyramid*>{ &p0, &p1, &p2 }, func);
 }
 
 
 void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
-                    HipaccPyramid &p3, HipaccPyramid &p4,
-                    const std::function<void()> func) {
-    assert(p0.depth_ == p1.depth_ &&
-           p1.depth_ == p2.depth_ &&
-           p2.depth_ == p3.depth_ &&
-           p3.depth_ == p4.depth_ &&
-           "Pyramid depths do not match.");
-
-    assert(p0.bind() && "Pyramid already bound to another traversal.");
-    assert(p1.bind() && "Pyramid already bound to another traversal.");
-    assert(p2.bind() && "Pyramid already bound to another traversal.");
-    assert(p3.bind() && "Pyramid already bound to another traversal.");
-    assert(p4.bind() && "Pyramid already bound to another traversal.");
-
-    std::vector<HipaccPyramid*> pyrs;
-    pyrs.push_back(&p0);
-    pyrs.push_back(&p1);
-    pyrs.push_back(&p2);
-    pyrs.push_back(&p3);
-    pyrs.push_back(&p4);
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
-
-    (*hipaccTraverseFunc.back())();
-
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
-
-    p0.unbind();
-    p1.unbind();
-    p2.unbind();
-    p3.unbind();
-    p4.unbind();
+                    HipaccPyramid &p3, const std::function<void()> &func) {
+    hipaccTraverse(std::vector<HipaccPyramid*>{ &p0, &p1, &p2, &p3 }, func);
 }
 
 
-void hipaccTraverse(std::vector<HipaccPyramid*> pyrs,
-                    const std::function<void()> func) {
-    for (size_t i=0; i<pyrs.size(); ++i) {
-        if (i < pyrs.size() - 1) {
-            assert(pyrs[i]->depth_ == pyrs[i+1]->depth_ && "Pyramid depths do not match.");
-        }
-        assert(pyrs[i]->bind() && "Pyramid already bound to another traversal.");
-    }
-
-    hipaccPyramids.push_back(pyrs);
-    hipaccTraverseFunc.push_back(&func);
-
-    (*hipaccTraverseFunc.back())();
-
-    hipaccTraverseFunc.pop_back();
-    hipaccPyramids.pop_back();
-
-    for (auto pyr : pyrs)
-        pyr->unbind();
+void hipaccTraverse(HipaccPyramid &p0, HipaccPyramid &p1, HipaccPyramid &p2,
+                    HipaccPyramid &p3, HipaccPyramid &p4,
+                    const std::function<void()> &func) {
+    hipaccTraverse(std::vector<HipaccPyramid*>{ &p0, &p1, &p2, &p3, &p4 }, func);
 }
 
 
 void hipaccTraverse(unsigned int loop=1,
-                    const std::function<void()> func=[]{}) {
-    assert(!hipaccPyramids.empty() && "Traverse recursion called outside of traverse.");
-
-    std::vector<HipaccPyramid*> pyrs = hipaccPyramids.back();
-
-    if (!pyrs.at(0)->is_bottom_level()) {
-        for (auto pyr : pyrs)
+                    const std::function<void()> &func=[]{}) {
+    std::vector<hipacc_traversal> &traversals = hipaccTraversals();
+    assert(!traversals.empty() && "Traverse recursion called outside of traverse.");
+
+    // nested traversals may grow the stack, hence it is indexed
+    size_t cur = traversals.size() - 1;
+    if (!traversals[cur].pyrs.at(0)->is_bottom_level()) {
+        for (auto pyr : traversals[cur].pyrs)
             ++pyr->level_;
 
         for (size_t i=0; i<loop; i++) {
-            (*hipaccTraverseFunc.back())();
+            (*traversals[cur].func)();
             if (i < loop-1) {
                 func();
             }
         }
 
-        for (auto pyr : pyrs)
+        for (auto pyr : traversals[cur].pyrs)
             --pyr->level_;
     }
 }
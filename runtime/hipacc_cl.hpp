@@ -38,8 +38,10 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -48,6 +50,9 @@
 #include <string>
 #include <utility>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "hipacc_base.hpp"
 
 #define EVENT_TIMING
@@ -381,8 +386,8 @@ void hipaccCreateContextsAndCommandQueues(bool all_devies=false) {
 }
 
 
-// Get binary from OpenCL program and dump it to stderr
-void hipaccDumpBinary(cl_program program, cl_device_id device) {
+// Get binaries from OpenCL program for all associated devices
+std::vector<std::pair<cl_device_id, std::string> > hipaccGetBinaries(cl_program program) {
     cl_uint num_devices;
 
     // Get the number of devices associated with the program
@@ -404,20 +409,193 @@ void hipaccDumpBinary(cl_program program, cl_device_id device) {
     err |= clGetProgramInfo(program, CL_PROGRAM_BINARIES,  sizeof(unsigned char *)*binaries.size(), binaries.data(), NULL);
     checkErr(err, "clGetProgramInfo()");
 
-    for (size_t i=0; i<devices.size(); ++i) {
-        if (devices[i] == device) {
+    std::vector<std::pair<cl_device_id, std::string> > result;
+    for (size_t i=0; i<num_devices; i++) {
+        result.push_back(std::make_pair(devices[i],
+                    std::string((char *)binaries[i], binary_sizes[i])));
+        delete[] binaries[i];
+    }
+
+    return result;
+}
+
+
+// Get binary from OpenCL program and dump it to stderr
+void hipaccDumpBinary(cl_program program, cl_device_id device) {
+    for (auto &binary : hipaccGetBinaries(program)) {
+        if (binary.first == device) {
             std::cerr << "OpenCL binary : " << std::endl;
             // binary can contain any character, emit char by char
-            for (size_t n=0; n<binary_sizes[i]; ++n) {
-                std::cerr << binaries[i][n];
+            for (size_t n=0; n<binary.second.size(); ++n) {
+                std::cerr << binary.second[n];
             }
             std::cerr << std::endl;
         }
     }
+}
 
-    for (size_t i=0; i<num_devices; i++) {
-        delete[] binaries[i];
+
+// Persistent cache of OpenCL program binaries. Binaries are stored in the
+// directory named by the environment variable HIPACC_CL_CACHE, by default
+// ~/.hipacc_cl_cache, and are keyed by a hash of the source, the headers it
+// includes directly or through other headers, the build options, and the
+// devices; set HIPACC_CL_CACHE to 'off' to always build from source.
+std::string hipaccBinaryCacheFile(const std::string &file_name, const std::string &source, const std::string &build_options) {
+    const char *env = getenv("HIPACC_CL_CACHE");
+    const char *home = getenv("HOME");
+    std::string dir;
+    if (env && *env) {
+        if (std::string(env) == "off") return std::string();
+        dir = env;
+    } else if (home && *home) {
+        dir = std::string(home) + "/.hipacc_cl_cache";
+    } else {
+        return std::string();
+    }
+    mkdir(dir.c_str(), 0755);
+
+    // include directories: directory of the source and -I options
+    std::vector<std::string> include_dirs;
+    size_t slash = file_name.rfind('/');
+    include_dirs.push_back(slash == std::string::npos ? "." : file_name.substr(0, slash));
+    std::istringstream options(build_options);
+    std::string option;
+    while (options >> option) {
+        if (option == "-I") {
+            if (options >> option) include_dirs.push_back(option);
+        } else if (option.compare(0, 2, "-I") == 0) {
+            include_dirs.push_back(option.substr(2));
+        }
+    }
+
+    // add the headers included by code to the key, each header once; quoted
+    // includes are looked up in the directory of the including file first.
+    // The nesting depth is bounded, as the paths of cyclic relative includes
+    // may never repeat.
+    std::string key = source + '\0' + build_options;
+    std::vector<std::string> headers;
+    std::function<void(const std::string &, const std::string &, int)> add_includes =
+        [&] (const std::string &code, const std::string &code_dir, int depth) {
+        if (depth > 200) return;
+        std::istringstream lines(code);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line.compare(begin, 1, "#") != 0) continue;
+            begin = line.find("include", begin);
+            if (begin == std::string::npos) continue;
+            begin = line.find_first_of("\"<", begin);
+            if (begin == std::string::npos) continue;
+            bool quoted = line[begin++] == '"';
+            std::string header = line.substr(begin, line.find(quoted ? '"' : '>', begin) - begin);
+
+            std::vector<std::string> dirs;
+            if (quoted) dirs.push_back(code_dir);
+            dirs.insert(dirs.end(), include_dirs.begin(), include_dirs.end());
+            for (auto &dir : dirs) {
+                std::string path = dir + "/" + header;
+                std::ifstream headerFile(path.c_str());
+                if (!headerFile.is_open()) continue;
+                if (std::find(headers.begin(), headers.end(), path) == headers.end()) {
+                    headers.push_back(path);
+                    std::string content((std::istreambuf_iterator<char>(headerFile)),
+                                        std::istreambuf_iterator<char>());
+                    key += '\0' + content;
+                    add_includes(content, path.substr(0, path.rfind('/')), depth + 1);
+                }
+                break;
+            }
+        }
+    };
+    add_includes(source, include_dirs[0], 0);
+
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    for (auto device : Ctx.get_devices()) {
+        for (cl_device_info info : { CL_DEVICE_NAME, CL_DEVICE_VERSION, CL_DRIVER_VERSION }) {
+            size_t size = 0;
+            clGetDeviceInfo(device, info, 0, NULL, &size);
+            std::vector<char> value(size);
+            clGetDeviceInfo(device, info, size, value.data(), NULL);
+            key += '\0';
+            key.append(value.data(), size);
+        }
     }
+
+    // 64-bit FNV-1a hash
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto c : key) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+
+    std::stringstream ss;
+    ss << dir << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return ss.str();
+}
+
+
+// Create and build program from cached binaries; returns NULL if there is no
+// valid binary for every device
+cl_program hipaccLoadBinaries(const std::string &cache_file, const std::string &build_options) {
+    if (cache_file.empty()) return NULL;
+    std::ifstream binFile(cache_file.c_str(), std::ios::binary);
+    if (!binFile.is_open()) return NULL;
+
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<cl_device_id> devices = Ctx.get_devices();
+    std::vector<std::string> binaries(devices.size());
+    for (auto &binary : binaries) {
+        uint64_t size = 0;
+        binFile.read((char *)&size, sizeof(size));
+        if (!binFile || size == 0) return NULL;
+        binary.resize(size);
+        binFile.read(&binary[0], size);
+        if (!binFile) return NULL;
+    }
+
+    std::vector<size_t> binary_sizes;
+    std::vector<const unsigned char *> binary_ptrs;
+    for (auto &binary : binaries) {
+        binary_sizes.push_back(binary.size());
+        binary_ptrs.push_back((const unsigned char *)binary.data());
+    }
+
+    cl_int err = CL_SUCCESS;
+    std::vector<cl_int> binary_status(devices.size());
+    cl_program program = clCreateProgramWithBinary(Ctx.get_contexts()[0], devices.size(), devices.data(), binary_sizes.data(), binary_ptrs.data(), binary_status.data(), &err);
+    if (err != CL_SUCCESS) return NULL;
+
+    err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+    if (err != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+
+// Store binaries of program in the cache, ordered like the context devices
+void hipaccStoreBinaries(const std::string &cache_file, cl_program program) {
+    if (cache_file.empty()) return;
+
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    std::vector<std::pair<cl_device_id, std::string> > binaries = hipaccGetBinaries(program);
+    std::string tmp_file = cache_file + "." + std::to_string(getpid());
+    std::ofstream binFile(tmp_file.c_str(), std::ios::binary);
+    for (auto device : Ctx.get_devices()) {
+        for (auto &binary : binaries) {
+            if (binary.first != device) continue;
+            uint64_t size = binary.second.size();
+            binFile.write((const char *)&size, sizeof(size));
+            binFile.write(binary.second.data(), size);
+        }
+    }
+    binFile.close();
+
+    // rename is atomic, concurrent processes never read a partial file
+    if (!binFile || rename(tmp_file.c_str(), cache_file.c_str()) != 0)
+        remove(tmp_file.c_str());
 }
 
 
@@ -441,8 +619,6 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     const char *c_str = clString.c_str();
 
     if (print_progress) std::cerr << "<HIPACC:> Compiling '" << kernel_name << "' .";
-    program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
-    checkErr(err, "clCreateProgramWithSource()");
 
     cl_platform_name platform_name = Ctx.get_platform_names()[0];
     if (build_options.empty()) {
@@ -467,7 +643,18 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     if (!build_includes.empty()) {
         build_options += " " + build_includes;
     }
-    err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+
+    // load binaries from the cache, else build from source; the cache is not
+    // used if the build log is requested
+    std::string cache_file = print_log ? std::string() :
+        hipaccBinaryCacheFile(file_name, clString, build_options);
+    program = hipaccLoadBinaries(cache_file, build_options);
+    bool cached = program != NULL;
+    if (!cached) {
+        program = clCreateProgramWithSource(Ctx.get_contexts()[0], 1, (const char **)&c_str, &length, &err);
+        checkErr(err, "clCreateProgramWithSource()");
+        err = clBuildProgram(program, 0, NULL, build_options.c_str(), NULL, NULL);
+    }
     if (print_progress) std::cerr << ".";
 
     cl_build_status build_status;
@@ -502,6 +689,7 @@ cl_kernel hipaccBuildProgramAndKernel(std::string file_name, std::string kernel_
     }
     checkErr(err, "clBuildProgram(), clGetProgramBuildInfo()");
 
+    if (!cached) hipaccStoreBinaries(cache_file, program);
     if (dump_binary) hipaccDumpBinary(program, Ctx.get_devices()[0]);
 
     kernel = clCreateKernel(program, kernel_name.c_str(), &err);
@@ -886,7 +1074,14 @@ void hipaccEnqueueKernel(cl_kernel kernel, size_t *global_work_size, size_t *loc
     #endif
 
     last_gpu_timing = (end-start)*1.0e-3f;
-    if (print_timing) {
+    if (hipaccTraceEnabled()) {
+        char kernel_name[256];
+        err = clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, sizeof(kernel_name), kernel_name, NULL);
+        checkErr(err, "clGetKernelInfo()");
+        int64_t end_time = hipacc_time_micro();
+        hipaccTraceKernel(std::string(kernel_name), global_work_size[0], global_work_size[1],
+                          end_time - (int64_t)(end-start), end_time);
+    } else if (print_timing) {
         std::cerr << "<HIPACC:> Kernel timing (" << local_work_size[0]*local_work_size[1] << ": " << local_work_size[0] << "x" << local_work_size[1] << "): " << last_gpu_timing << "(ms)" << std::endl;
     }
 }
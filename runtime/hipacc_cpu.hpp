@@ -30,11 +30,20 @@
 #include <stddef.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <cfloat>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "hipacc_base.hpp"
+#include "hipacc_cpu_threads.hpp"
+#include "hipacc_cpu_tuning.hpp"
+
+#define HIPACC_NUM_WARMUP 1
 
 class HipaccContext : public HipaccContextBase {
     public:
@@ -43,6 +52,10 @@ class HipaccContext : public HipaccContextBase {
 
             return instance;
         }
+
+        template<typename T>
+        static void create_pyramid_levels(std::vector<HipaccImage> &levels,
+                                          HipaccImage &base, size_t depth);
 };
 
 long start_time = 0L;
@@ -52,21 +65,160 @@ void hipaccStartTiming() {
     start_time = hipacc_time_micro();
 }
 
-void hipaccStopTiming() {
+// the timing is recorded in the trace if tracing is enabled, else printed
+void hipaccStopTiming(const char *kernel, size_t width, size_t height) {
     end_time = hipacc_time_micro();
     last_gpu_timing = (end_time - start_time) * 1.0e-3f;
 
+    if (hipaccTraceEnabled()) {
+        hipaccTraceKernel(kernel, (int)width, (int)height, start_time, end_time);
+        return;
+    }
     std::cerr << "<HIPACC:> Kernel timing: "
               << last_gpu_timing << "(ms)" << std::endl;
 }
 
+void hipaccStopTiming() {
+    hipaccStopTiming("kernel", 0, 0);
+}
+
+
+// Append the result of a kernel benchmark to the CSV file named by the
+// environment variable HIPACC_BENCH; rows are labeled by HIPACC_BENCH_LABEL
+void hipaccWriteBenchmark(const char *kernel, size_t width, size_t height,
+                          const std::vector<float> &times) {
+    const char *file = getenv("HIPACC_BENCH");
+    if (!file || !*file)
+        return;
+    const char *label = getenv("HIPACC_BENCH_LABEL");
+
+    bool empty = std::ifstream(file).peek() == std::ifstream::traits_type::eof();
+    std::ofstream os(file, std::ios::app);
+    if (!os) {
+        std::cerr << "<HIPACC:> Could not write benchmark results to "
+                  << file << std::endl;
+        return;
+    }
+    if (empty)
+        os << "label,kernel,width,height,iterations,median_ms,min_ms,max_ms,mpixel_s\n";
+    float median = times[times.size()/2];
+    os << "\"" << (label ? label : "") << "\"," << kernel << ","
+       << width << "," << height << "," << times.size() << ","
+       << median << "," << times.front() << "," << times.back() << ","
+       << width*height/(median*1.0e3f) << "\n";
+}
+
+
+// Benchmark timing for a kernel call: the kernel is executed
+// HIPACC_NUM_WARMUP times untimed, then HIPACC_NUM_ITERATIONS times timed
+template<typename F>
+void hipaccLaunchKernelBenchmark(const char *kernel_name, size_t width,
+                                 size_t height, F kernel, bool print_timing=true) {
+    std::vector<float> times;
+
+    for (size_t i=0; i<HIPACC_NUM_WARMUP; ++i)
+        kernel();
+
+    for (size_t i=0; i<HIPACC_NUM_ITERATIONS; ++i) {
+        int64_t start = hipacc_time_micro();
+        kernel();
+        int64_t end = hipacc_time_micro();
+        times.push_back((end - start) * 1.0e-3f);
+        if (hipaccTraceEnabled())
+            hipaccTraceKernel(kernel_name, (int)width, (int)height, start, end);
+    }
+
+    std::sort(times.begin(), times.end());
+    last_gpu_timing = times[times.size()/2];
+    hipaccWriteBenchmark(kernel_name, width, height, times);
+
+    if (print_timing) {
+        std::cerr << "<HIPACC:> Kernel timing benchmark (" << kernel_name
+                  << ": " << width << "x" << height << "): "
+                  << last_gpu_timing << " | " << times.front() << " | " << times.back()
+                  << " (median(" << HIPACC_NUM_ITERATIONS << ") | minimum | maximum) ms, "
+                  << width*height/(last_gpu_timing*1.0e3f) << " Mpixel/s" << std::endl;
+    }
+}
+
+
+// Perform configuration exploration for a kernel call: the number of bands of
+// rows executed by the thread pool is tuned once per kernel, iteration space
+// size, and CPU, and is then taken from the tuning database
+template<typename F>
+void hipaccLaunchKernelExploration(const char *kernel_name, HipaccAccessor &is,
+                                   int num_threads, F kernel) {
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    HipaccTuningDB &db = HipaccTuningDB::getInstance();
+    std::string key = db.key(kernel_name, is.width, is.height, pool.size());
+
+    int opt_bands = db.lookup(key);
+    if (opt_bands) {
+        hipaccStartTiming();
+        hipaccLaunchKernelBands(is, opt_bands, pool, kernel);
+        hipaccStopTiming(kernel_name, is.width, is.height);
+        return;
+    }
+
+    // one band, one band per thread, and more bands for load balancing
+    std::vector<int> candidates;
+    for (int bands=1; bands<(int)pool.size(); bands*=2)
+        candidates.push_back(bands);
+    for (int bands=pool.size(); bands<=4*(int)pool.size(); bands*=2)
+        candidates.push_back(bands);
+
+    float opt_time = FLT_MAX;
+    std::cerr << "<HIPACC:> Exploring configurations for kernel '"
+              << kernel_name << "' (" << is.width << "x" << is.height
+              << ", " << pool.size() << " threads)" << std::endl;
+
+    for (auto bands : candidates) {
+        if (bands > (int)is.height)
+            break;
+        std::vector<float> times;
+
+        hipaccLaunchKernelBands(is, bands, pool, kernel);
+        for (size_t i=0; i<HIPACC_NUM_ITERATIONS; ++i) {
+            int64_t start = hipacc_time_micro();
+            hipaccLaunchKernelBands(is, bands, pool, kernel);
+            times.push_back((hipacc_time_micro() - start) * 1.0e-3f);
+        }
+
+        std::sort(times.begin(), times.end());
+        last_gpu_timing = times[times.size()/2];
+
+        if (last_gpu_timing < opt_time) {
+            opt_time = last_gpu_timing;
+            opt_bands = bands;
+        }
+
+        std::cerr << "<HIPACC:> Kernel config: "
+                  << std::setw(4) << std::right << bands << " bands: "
+                  << std::setw(8) << std::fixed << std::setprecision(4)
+                  << last_gpu_timing << " | " << times.front() << " | " << times.back()
+                  << " (median(" << HIPACC_NUM_ITERATIONS << ") | minimum | maximum) ms" << std::endl;
+    }
+    last_gpu_timing = opt_time;
+    db.store(key, opt_bands);
+    std::cerr << "<HIPACC:> Best configuration for kernel '" << kernel_name
+              << "': " << opt_bands << " bands: " << opt_time << " ms"
+              << std::endl;
+}
+
 
+// The host memory aliases the image memory unless rows are padded; padded
+// images get a separate host buffer, which is only filled when read.
 template<typename T>
 HipaccImage createImage(T *host_mem, void *mem, size_t width, size_t height, size_t stride, size_t alignment, hipaccMemoryType mem_type=Global) {
-    HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), mem, mem_type);
+    bool alias = stride == width;
+    char *host = alias ? (char *)mem : new char[sizeof(T)*width*height];
+    HipaccImage img = HipaccImage(width, height, stride, alignment, sizeof(T), mem, mem_type, host, !alias);
     HipaccContext &Ctx = HipaccContext::getInstance();
     Ctx.add_image(img);
-    hipaccWriteMemory(img, host_mem ? host_mem : (T*)img.host);
+    if (host_mem)
+        hipaccWriteMemory(img, host_mem);
+    else
+        std::memset(mem, 0, sizeof(T)*stride*height);
 
     return img;
 }
@@ -79,40 +231,118 @@ HipaccImage hipaccCreateMemory(T *host_mem, size_t width, size_t height, size_t
     alignment = (int)ceilf((float)alignment/sizeof(T)) * sizeof(T);
     int stride = (int)ceilf((float)(width)/(alignment/sizeof(T))) * (alignment/sizeof(T));
 
-    T *mem = new T[stride*height];
-    return createImage(host_mem, (void *)mem, width, height, stride, alignment);
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    void *mem = Ctx.get_pool().alloc(sizeof(T), stride, height, alignment);
+    return createImage(host_mem, mem, width, height, stride, alignment);
 }
 
 
 // Allocate memory without any alignment considerations
 template<typename T>
 HipaccImage hipaccCreateMemory(T *host_mem, size_t width, size_t height) {
-    T *mem = new T[width*height];
-    return createImage(host_mem, (void *)mem, width, height, width, 0);
+    HipaccContext &Ctx = HipaccContext::getInstance();
+    void *mem = Ctx.get_pool().alloc(sizeof(T), width, height);
+    return createImage(host_mem, mem, width, height, width, 0);
+}
+
+
+// Allocate levels 1 to depth-1 of a pyramid from a single buffer; each level
+// starts at a multiple of the alignment of the base image, at least 64 bytes
+template<typename T>
+void HipaccContext::create_pyramid_levels(std::vector<HipaccImage> &levels,
+                                          HipaccImage &base, size_t depth) {
+    size_t alignment = std::max<size_t>(64, base.alignment);
+    size_t pixels = base.alignment ? base.alignment/sizeof(T) : 1;
+    std::vector<size_t> offsets, strides;
+    size_t size = 0;
+
+    size_t width  = base.width  / 2;
+    size_t height = base.height / 2;
+    for (size_t i=1; i<depth; ++i) {
+        assert(width * height > 0 && "Pyramid stages too deep for image size");
+        strides.push_back((width + pixels - 1) / pixels * pixels);
+        offsets.push_back(size);
+        size += (strides.back()*height*sizeof(T) + alignment - 1) / alignment * alignment;
+        width  /= 2;
+        height /= 2;
+    }
+    if (strides.empty())
+        return;
+
+    HipaccContext &Ctx = getInstance();
+    char *mem = (char *)Ctx.get_pool().alloc(1, size, 1, alignment);
+    width  = base.width  / 2;
+    height = base.height / 2;
+    for (size_t i=0; i<strides.size(); ++i) {
+        // only the first level holds the buffer, which is returned to the
+        // pool on release; releasing the other levels does not free memory
+        levels.push_back(createImage<T>(NULL, mem + offsets[i], width, height,
+                                        strides[i], base.alignment));
+        width  /= 2;
+        height /= 2;
+    }
+}
+
+
+// Allocate memory for a pyramid level matching the base image
+template<typename T>
+HipaccImage hipaccCreatePyramidImage(HipaccImage &base, size_t width, size_t height) {
+    if (base.alignment > 0) {
+        return hipaccCreateMemory<T>(NULL, width, height, base.alignment);
+    } else {
+        return hipaccCreateMemory<T>(NULL, width, height);
+    }
+}
+
+
+// Allocate a ring buffer holding only 'rows' rows of an image; rows are
+// addressed modulo 'rows' by streamed kernels, which is a power of two
+template<typename T>
+HipaccImage hipaccCreateRingBuffer(size_t width, size_t height, size_t rows, size_t alignment) {
+    HipaccImage img = hipaccCreateMemory<T>(NULL, width, rows, alignment);
+    img.height = height;
+
+    return img;
 }
 
 
-// Release memory
+template<typename T>
+HipaccImage hipaccCreateRingBuffer(size_t width, size_t height, size_t rows) {
+    HipaccImage img = hipaccCreateMemory<T>(NULL, width, rows);
+    img.height = height;
+
+    return img;
+}
+
+
+// Release memory: buffers are returned to the pool for reuse
 template<typename T>
 void hipaccReleaseMemory(HipaccImage &img) {
     HipaccContext &Ctx = HipaccContext::getInstance();
-    delete[] (T*)img.mem;
+    HipaccTaskGraph::getInstance().wait(img.mem, true);
+    Ctx.get_pool().release(img.mem);
     Ctx.del_image(img);
 }
 
 
+// Statistics of the memory pool
+hipacc_pool_stats hipaccGetMemoryStats() {
+    return HipaccContext::getInstance().get_pool().stats();
+}
+
+
 // Write to memory
 template<typename T>
 void hipaccWriteMemory(HipaccImage &img, T *host_mem) {
+    // nothing to do for host memory aliasing the image memory
     if (host_mem == NULL) return;
+    HipaccTaskGraph::getInstance().wait(img.mem, true);
+    if ((void *)host_mem == img.mem) return;
 
     size_t width  = img.width;
     size_t height = img.height;
     size_t stride = img.stride;
 
-    if ((char *)host_mem != img.host)
-        std::copy(host_mem, host_mem + width*height, (T*)img.host);
-
     if (stride > width) {
         for (size_t i=0; i<height; ++i) {
             std::memcpy(&((T*)img.mem)[i*stride], &host_mem[i*width], sizeof(T)*width);
@@ -130,6 +360,12 @@ T *hipaccReadMemory(HipaccImage &img) {
     size_t height = img.height;
     size_t stride = img.stride;
 
+    HipaccTaskGraph::getInstance().wait(img.mem, false);
+
+    // host memory aliases the image memory
+    if ((void *)img.host == img.mem)
+        return (T*)img.host;
+
     if (stride > width) {
         for (size_t i=0; i<height; ++i) {
             std::memcpy(&((T*)img.host)[i*width], &((T*)img.mem)[i*stride], sizeof(T)*width);
@@ -144,6 +380,8 @@ T *hipaccReadMemory(HipaccImage &img) {
 
 // Copy from memory to memory
 void hipaccCopyMemory(HipaccImage &src, HipaccImage &dst) {
+    HipaccTaskGraph::getInstance().wait(src.mem, false);
+    HipaccTaskGraph::getInstance().wait(dst.mem, true);
     size_t height = src.height;
     size_t stride = src.stride;
     std::memcpy(dst.mem, src.mem, src.pixel_size*stride*height);
@@ -168,6 +406,8 @@ void hipaccWriteDomainFromMask(HipaccImage &dom, T* host_mem) {
 
 // Copy from memory region to memory region
 void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst) {
+    HipaccTaskGraph::getInstance().wait(src.img.mem, false);
+    HipaccTaskGraph::getInstance().wait(dst.img.mem, true);
     for (size_t i=0; i<dst.height; ++i) {
         std::memcpy(&((uchar*)dst.img.mem)[dst.offset_x*dst.img.pixel_size + (dst.offset_y + i)*dst.img.stride*dst.img.pixel_size],
                     &((uchar*)src.img.mem)[src.offset_x*src.img.pixel_size + (src.offset_y + i)*src.img.stride*src.img.pixel_size],
@@ -175,5 +415,306 @@ void hipaccCopyMemoryRegion(const HipaccAccessor &src, const HipaccAccessor &dst
     }
 }
 
+
+// Perform global reduction: each block of rows of the iteration space is
+// reduced to a partial result, the partial results are combined pairwise.
+// There is no neutral element of reduce, hence the iteration space must not
+// be empty; T() is returned otherwise.
+template<typename T, typename F>
+T hipaccApplyReduction(F reduce, const HipaccAccessor &acc, int num_threads) {
+    int width = (int)acc.width;
+    int height = (int)acc.height;
+    assert(width > 0 && height > 0 && "Empty iteration space for global reduction");
+    if (width <= 0 || height <= 0)
+        return T();
+
+    HipaccTaskGraph::getInstance().wait(acc.img.mem, false);
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    int num_blocks = std::max(1, std::min<int>(height,
+                num_threads ? num_threads : (int)pool.size()));
+    size_t stride = acc.img.stride;
+    const T *mem = (const T *)acc.img.mem;
+    std::vector<T> partial(num_blocks);
+
+    pool.run(num_blocks, [&] (int block) {
+        int start_y = acc.offset_y + (int)((int64_t)height * block / num_blocks);
+        int end_y = acc.offset_y + (int)((int64_t)height * (block + 1) / num_blocks);
+        const T *row = mem + start_y*stride + acc.offset_x;
+        T result = row[0];
+        for (int x=1; x<width; ++x)
+            result = reduce(result, row[x]);
+        for (int y=start_y+1; y<end_y; ++y) {
+            row = mem + y*stride + acc.offset_x;
+            for (int x=0; x<width; ++x)
+                result = reduce(result, row[x]);
+        }
+        partial[block] = result;
+    });
+
+    // tree-combine partial results, preserving the order of the blocks
+    for (int step=1; step<num_blocks; step*=2) {
+        for (int i=0; i+step<num_blocks; i+=2*step)
+            partial[i] = reduce(partial[i], partial[i+step]);
+    }
+
+    return partial[0];
+}
+
+
+enum hipaccScanMode {
+    ScanRow,
+    ScanColumn,
+    ScanImage
+};
+
+// Perform inclusive scan of the iteration space in place, combining pixels by
+// reduce along rows, along columns, or both (integral image). Each block of
+// rows is scanned on its own, where the columns are combined row by row over
+// the whole width; then the last row of each block is carried into the last
+// row of the next block, and the carry is applied to the other rows of the
+// blocks in parallel. reduce has to be associative, and for ScanImage also
+// commutative.
+template<typename T, T (*reduce)(T, T)>
+void hipaccApplyScan(const HipaccAccessor &acc, hipaccScanMode mode,
+                     int num_threads) {
+    HipaccTaskGraph::getInstance().wait(acc.img.mem, true);
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    int width = (int)acc.width;
+    int height = (int)acc.height;
+    int num_blocks = std::max(1, std::min<int>(height,
+                num_threads ? num_threads : (int)pool.size()));
+    size_t stride = acc.img.stride;
+    T *mem = (T *)acc.img.mem + acc.offset_y*stride + acc.offset_x;
+    auto start_y = [&] (int block) {
+        return (int)((int64_t)height * block / num_blocks);
+    };
+
+    pool.run(num_blocks, [&] (int block) {
+        for (int y=start_y(block); y<start_y(block + 1); ++y) {
+            T *row = mem + y*stride;
+            if (mode != ScanColumn) {
+                for (int x=1; x<width; ++x)
+                    row[x] = reduce(row[x-1], row[x]);
+            }
+            if (mode != ScanRow && y > start_y(block)) {
+                const T *prev = row - stride;
+                for (int x=0; x<width; ++x)
+                    row[x] = reduce(prev[x], row[x]);
+            }
+        }
+    });
+    if (mode == ScanRow || num_blocks == 1)
+        return;
+
+    for (int block=1; block<num_blocks; ++block) {
+        const T *carry = mem + (start_y(block) - 1)*stride;
+        T *last = mem + (start_y(block + 1) - 1)*stride;
+        for (int x=0; x<width; ++x)
+            last[x] = reduce(carry[x], last[x]);
+    }
+
+    pool.run(num_blocks - 1, [&] (int block) {
+        const T *carry = mem + (start_y(block + 1) - 1)*stride;
+        for (int y=start_y(block + 1); y<start_y(block + 2) - 1; ++y) {
+            T *row = mem + y*stride;
+            for (int x=0; x<width; ++x)
+                row[x] = reduce(carry[x], row[x]);
+        }
+    });
+}
+
+// Binning of kernels: the generated binning function derives from
+// HipaccBinning and contributes values to the bins of its thread by
+// bin(idx) = value, which are combined by the reduce function of the kernel.
+// Contributions to bins beyond num_bins are dropped.
+template<typename B, B (*reduce)(B, B)>
+class HipaccBinning {
+    public:
+        class Bin {
+            private:
+                B *bin_;
+
+            public:
+                explicit Bin(B *bin) : bin_(bin) {}
+
+                Bin &operator=(const B &value) {
+                    if (bin_)
+                        *bin_ = reduce(*bin_, value);
+                    return *this;
+                }
+        };
+
+        B *bins;
+        unsigned num_bins;
+
+        Bin bin(unsigned idx) {
+            return Bin(idx < num_bins ? bins + idx : nullptr);
+        }
+
+        static B combine(B left, B right) { return reduce(left, right); }
+};
+
+
+// Perform binning: each block of rows of the iteration space is binned into
+// private bins starting at B(), which are combined in order of the blocks
+template<typename T, typename B, typename F>
+B *hipaccApplyBinning(F binning, const HipaccAccessor &acc, unsigned num_bins,
+                      int num_threads, std::vector<B> &bins) {
+    HipaccTaskGraph::getInstance().wait(acc.img.mem, false);
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    int width = (int)acc.width;
+    int height = (int)acc.height;
+    int num_blocks = std::max(1, std::min<int>(height,
+                num_threads ? num_threads : (int)pool.size()));
+    size_t stride = acc.img.stride;
+    const T *mem = (const T *)acc.img.mem;
+    std::vector<std::vector<B>> partial(num_blocks,
+            std::vector<B>(num_bins, B()));
+
+    pool.run(num_blocks, [&] (int block) {
+        int start_y = (int)((int64_t)height * block / num_blocks);
+        int end_y = (int)((int64_t)height * (block + 1) / num_blocks);
+        F fun(binning);
+        fun.bins = partial[block].data();
+        fun.num_bins = num_bins;
+        for (int y=start_y; y<end_y; ++y) {
+            const T *row = mem + (y + acc.offset_y)*stride + acc.offset_x;
+            for (int x=0; x<width; ++x)
+                fun(x, y, row[x]);
+        }
+    });
+
+    bins.swap(partial[0]);
+    for (int block=1; block<num_blocks; ++block) {
+        for (unsigned idx=0; idx<num_bins; ++idx)
+            bins[idx] = F::combine(bins[idx], partial[block][idx]);
+    }
+
+    return bins.data();
+}
+
+
+// Histogram of 8-bit data, bin(pixel) = weight with reduce(left, right) =
+// left + right: each block counts into four private sub-histograms, which
+// are updated in turn for consecutive pixels, so that runs of equal pixels
+// do not serialize on the same counter. Pixels are loaded eight at a time.
+template<typename B>
+B *hipaccApplyHistogram(const HipaccAccessor &acc, unsigned num_bins,
+                        B weight, int num_threads, std::vector<B> &bins) {
+    HipaccTaskGraph::getInstance().wait(acc.img.mem, false);
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    int width = (int)acc.width;
+    int height = (int)acc.height;
+    int num_blocks = std::max(1, std::min<int>(height,
+                num_threads ? num_threads : (int)pool.size()));
+    size_t stride = acc.img.stride;
+    const uint8_t *mem = (const uint8_t *)acc.img.mem;
+    std::vector<std::vector<uint32_t>> partial(num_blocks,
+            std::vector<uint32_t>(4*256));
+
+    pool.run(num_blocks, [&] (int block) {
+        int start_y = (int)((int64_t)height * block / num_blocks);
+        int end_y = (int)((int64_t)height * (block + 1) / num_blocks);
+        uint32_t *h0 = partial[block].data(), *h1 = h0 + 256,
+                 *h2 = h0 + 512, *h3 = h0 + 768;
+        for (int y=start_y; y<end_y; ++y) {
+            const uint8_t *row = mem + (y + acc.offset_y)*stride + acc.offset_x;
+            int x = 0;
+            for (; x+8<=width; x+=8) {
+                uint64_t pixels;
+                std::memcpy(&pixels, row + x, sizeof(pixels));
+                h0[pixels & 0xff]++;
+                h1[(pixels >> 8) & 0xff]++;
+                h2[(pixels >> 16) & 0xff]++;
+                h3[(pixels >> 24) & 0xff]++;
+                h0[(pixels >> 32) & 0xff]++;
+                h1[(pixels >> 40) & 0xff]++;
+                h2[(pixels >> 48) & 0xff]++;
+                h3[pixels >> 56]++;
+            }
+            for (; x<width; ++x)
+                h0[row[x]]++;
+        }
+        for (int idx=0; idx<256; ++idx)
+            h0[idx] += h1[idx] + h2[idx] + h3[idx];
+    });
+
+    bins.assign(num_bins, B());
+    for (unsigned idx=0; idx<std::min(num_bins, 256u); ++idx) {
+        uint64_t count = 0;
+        for (int block=0; block<num_blocks; ++block)
+            count += partial[block][idx];
+        bins[idx] = (B)(count * weight);
+    }
+
+    return bins.data();
+}
+
+
+// Median filter for 8-bit data over a row of pixels, called by kernels with
+// large median windows: cols holds the size_y pixels of each column of the
+// row consecutively, out[x] gets the median of columns [x, x+size_x) for x in
+// [first, first+count). The histogram of the window is updated by removing
+// the leftmost and adding the next column, and the median is moved from its
+// previous value, so each pixel costs O(size_y) instead of a sort.
+void hipaccMedianRow(const unsigned char *cols, int size_x, int size_y,
+                     int first, int count, unsigned char *out) {
+    if (count <= 0)
+        return;
+
+    int hist[256] = { 0 };
+    int half = (size_x*size_y - 1) / 2;
+    const unsigned char *col = cols + first*size_y;
+    for (int i=0; i<size_x*size_y; ++i)
+        hist[col[i]]++;
+
+    // median m: less than half+1 values are below m, more are up to m
+    int m = 0, below = 0;
+    for (; below + hist[m] <= half; ++m)
+        below += hist[m];
+    out[first] = (unsigned char)m;
+
+    for (int x=first+1; x<first+count; ++x) {
+        const unsigned char *old_col = cols + (x-1)*size_y;
+        const unsigned char *new_col = cols + (x-1+size_x)*size_y;
+        for (int y=0; y<size_y; ++y) {
+            hist[old_col[y]]--;
+            below -= old_col[y] < m;
+            hist[new_col[y]]++;
+            below += new_col[y] < m;
+        }
+        while (below > half)
+            below -= hist[--m];
+        for (; below + hist[m] <= half; ++m)
+            below += hist[m];
+        out[x] = (unsigned char)m;
+    }
+}
+
+
+// Sum over a row of pixels, called by kernels summing over windows with equal
+// weights. T has to be an integer type, since floating-point sums updated by
+// adding and subtracting columns would depend on where the row band started.
+// cols holds the sums of the columns of the row, out[x] gets the sum of
+// columns [x, x+size_x) for x in [first, first+count). Each pixel adds the
+// next and subtracts the leftmost column, independent of the window size.
+template<typename T>
+void hipaccSlidingSumRow(const T *cols, int size_x, int first, int count,
+                         T *out) {
+    if (count <= 0)
+        return;
+
+    T sum = cols[first];
+    for (int i=1; i<size_x; ++i)
+        sum += cols[first+i];
+    out[first] = sum;
+
+    for (int x=first+1; x<first+count; ++x) {
+        sum += cols[x-1+size_x];
+        sum -= cols[x-1];
+        out[x] = sum;
+    }
+}
+
 #endif  // __HIPACC_CPU_HPP__
 
@@ -0,0 +1,450 @@
+//
+// Copyright (c) 2014, Saarland University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_CPU_THREADS_HPP__
+#define __HIPACC_CPU_THREADS_HPP__
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hipacc_base.hpp"
+
+// Persistent pool of worker threads executing C/C++ kernels. The calling
+// thread participates in the execution, so a pool of n threads spawns only
+// n-1 workers. Jobs are only numbered; each kernel launch computes the same
+// result as the sequential version regardless of the job-to-thread mapping.
+// In addition, the workers execute independent jobs from a queue, which are
+// submitted by the task graph of asynchronous kernel launches.
+class HipaccThreadPool {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> queue;
+        std::mutex mutex;
+        std::condition_variable work_cond, done_cond;
+        const std::function<void(int)> *job;
+        int num_jobs, next_job, pending_jobs;
+        size_t generation;
+        bool running, stop;
+
+        static bool &inPool() {
+            static thread_local bool in_pool = false;
+            return in_pool;
+        }
+
+        // execute jobs until all jobs of the current launch are taken
+        void work(std::unique_lock<std::mutex> &lock) {
+            while (next_job < num_jobs) {
+                int cur_job = next_job++;
+                lock.unlock();
+                (*job)(cur_job);
+                lock.lock();
+                if (--pending_jobs == 0)
+                    done_cond.notify_all();
+            }
+        }
+
+        void worker() {
+            inPool() = true;
+            size_t seen = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                work_cond.wait(lock, [&] {
+                    return stop || generation != seen || !queue.empty();
+                });
+                if (stop)
+                    return;
+                if (generation != seen) {
+                    seen = generation;
+                    work(lock);
+                    continue;
+                }
+                std::function<void()> queued = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                queued();
+                lock.lock();
+            }
+        }
+
+        explicit HipaccThreadPool(unsigned num_threads) :
+            job(nullptr),
+            num_jobs(0), next_job(0), pending_jobs(0),
+            generation(0),
+            running(false), stop(false)
+        {
+            for (unsigned i = 1; i < num_threads; ++i)
+                workers.emplace_back(&HipaccThreadPool::worker, this);
+        }
+
+        HipaccThreadPool(HipaccThreadPool const &);
+        void operator=(HipaccThreadPool const &);
+
+    public:
+        ~HipaccThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            work_cond.notify_all();
+            for (auto &thread : workers)
+                thread.join();
+        }
+
+        static unsigned hardwareThreads() {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // the pool is created on first use with the number of threads
+        // requested by the first launch (0 selects all hardware threads)
+        static HipaccThreadPool &getInstance(unsigned num_threads=0) {
+            static HipaccThreadPool instance(num_threads ? num_threads :
+                                             hardwareThreads());
+
+            return instance;
+        }
+
+        unsigned size() const { return workers.size() + 1; }
+
+        // execute func(0) ... func(n-1) and wait for completion; nested or
+        // concurrent launches are executed by the calling thread
+        void run(int n, const std::function<void(int)> &func) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (n <= 1 || workers.empty() || running || inPool()) {
+                lock.unlock();
+                for (int i = 0; i < n; ++i)
+                    func(i);
+                return;
+            }
+
+            job = &func;
+            num_jobs = n;
+            next_job = 0;
+            pending_jobs = n;
+            running = true;
+            ++generation;
+            work_cond.notify_all();
+
+            work(lock);
+            done_cond.wait(lock, [&] { return pending_jobs == 0; });
+            job = nullptr;
+            running = false;
+        }
+
+        // queue func for execution by a worker; without workers, func is
+        // executed by the calling thread
+        void submit(std::function<void()> func) {
+            if (workers.empty()) {
+                func();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(std::move(func));
+            }
+            work_cond.notify_one();
+        }
+
+        // execute a queued job by the calling thread, if there is any
+        bool runQueued() {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (queue.empty())
+                return false;
+            std::function<void()> queued = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            queued();
+            return true;
+        }
+};
+
+
+// Number of bands of rows an iteration space is split into. Bands have at
+// least hipacc_min_band_pixels pixels, so that small iteration spaces, such
+// as the coarse levels of a pyramid, are computed by a single thread.
+const int hipacc_min_band_pixels = 16384;
+
+int hipaccNumBands(HipaccAccessor &is, int num_threads, HipaccThreadPool &pool) {
+    int64_t pixels = (int64_t)is.width * is.height;
+    int num_bands = std::min<int>(is.height,
+            num_threads ? num_threads : (int)pool.size());
+    return std::max(1, std::min<int>(num_bands,
+                (int)(pixels / hipacc_min_band_pixels)));
+}
+
+
+// Execute kernel(start_y, end_y) for num_bands disjoint bands of rows
+// covering the iteration space. Every pixel is written by exactly one band,
+// hence the output is identical to the sequential execution.
+template<typename F>
+void hipaccLaunchKernelBands(HipaccAccessor &is, int num_bands,
+                             HipaccThreadPool &pool, F kernel) {
+    int height = (int)is.height;
+    int first_y = is.offset_y;
+
+    if (num_bands <= 1) {
+        kernel(first_y, first_y + height);
+        return;
+    }
+
+    pool.run(num_bands, [&] (int band) {
+        int start_y = first_y + (int)((int64_t)height * band / num_bands);
+        int end_y = first_y + (int)((int64_t)height * (band + 1) / num_bands);
+        kernel(start_y, end_y);
+    });
+}
+
+
+template<typename F>
+void hipaccLaunchKernel(HipaccAccessor &is, int num_threads, F kernel) {
+    HipaccThreadPool &pool = HipaccThreadPool::getInstance(num_threads);
+    hipaccLaunchKernelBands(is, hipaccNumBands(is, num_threads, pool), pool,
+                            kernel);
+}
+
+
+// Graph of asynchronously launched kernels. Each launch is recorded as a task
+// reading and writing image memory; a task depends on the last writer of the
+// memory it reads and, for the memory it writes, also on all readers since.
+// Tasks are split into bands of rows once their dependences are finished.
+// Launches and waits are issued by the host thread only, which also deletes
+// finished tasks, so workers never destroy kernel arguments.
+class HipaccTaskGraph {
+    private:
+        struct Task {
+            std::function<void(int, int)> kernel;
+            const char *name;
+            int width;
+            int first_y, height, num_bands;
+            int pending_bands, pending_deps;
+            std::vector<Task *> succs;
+            bool done;
+        };
+        struct Access {
+            Task *writer;
+            std::vector<Task *> readers;
+        };
+
+        std::list<std::unique_ptr<Task>> tasks;
+        std::map<const void *, Access> accesses;
+        std::mutex mutex;
+        std::condition_variable done_cond;
+        HipaccThreadPool *pool;
+
+        HipaccTaskGraph() : pool(nullptr) {}
+        HipaccTaskGraph(HipaccTaskGraph const &);
+        void operator=(HipaccTaskGraph const &);
+
+        // forget finished tasks
+        void reap() {
+            for (auto iter = accesses.begin(); iter != accesses.end(); ) {
+                Access &acc = iter->second;
+                if (acc.writer && acc.writer->done)
+                    acc.writer = nullptr;
+                acc.readers.erase(std::remove_if(acc.readers.begin(),
+                            acc.readers.end(), [] (Task *t) { return t->done; }),
+                        acc.readers.end());
+                if (!acc.writer && acc.readers.empty())
+                    iter = accesses.erase(iter);
+                else
+                    ++iter;
+            }
+            tasks.remove_if([] (const std::unique_ptr<Task> &t) {
+                return t->done;
+            });
+        }
+
+        bool finished(const void *mem, bool write) {
+            auto iter = accesses.find(mem);
+            if (iter == accesses.end())
+                return true;
+            Access &acc = iter->second;
+            if (acc.writer && !acc.writer->done)
+                return false;
+            if (write)
+                for (auto reader : acc.readers)
+                    if (!reader->done)
+                        return false;
+            return true;
+        }
+
+        // must be called without holding the lock
+        void schedule(Task *task) {
+            for (int band = 0; band < task->num_bands; ++band) {
+                pool->submit([this, task, band] {
+                    int start_y = task->first_y +
+                        (int)((int64_t)task->height * band / task->num_bands);
+                    int end_y = task->first_y +
+                        (int)((int64_t)task->height * (band + 1) / task->num_bands);
+                    if (hipaccTraceEnabled()) {
+                        int64_t start = hipacc_time_micro();
+                        task->kernel(start_y, end_y);
+                        hipaccTraceKernel(task->name, task->width,
+                                end_y - start_y, start, hipacc_time_micro());
+                    } else {
+                        task->kernel(start_y, end_y);
+                    }
+                    finishBand(task);
+                });
+            }
+        }
+
+        void finishBand(Task *task) {
+            std::vector<Task *> ready;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--task->pending_bands)
+                    return;
+                task->done = true;
+                for (auto succ : task->succs)
+                    if (--succ->pending_deps == 0)
+                        ready.push_back(succ);
+            }
+            done_cond.notify_all();
+            for (auto succ : ready)
+                schedule(succ);
+        }
+
+        // help executing queued jobs until pred() holds
+        template<typename P>
+        void waitFor(P pred) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!pred()) {
+                lock.unlock();
+                bool ran = pool && pool->runQueued();
+                lock.lock();
+                if (!ran && !pred())
+                    done_cond.wait(lock);
+            }
+        }
+
+    public:
+        static HipaccTaskGraph &getInstance() {
+            static HipaccTaskGraph instance;
+
+            return instance;
+        }
+
+        void launch(HipaccAccessor &is, int num_threads,
+                    std::initializer_list<const void *> reads,
+                    std::initializer_list<const void *> writes,
+                    const char *name,
+                    std::function<void(int, int)> kernel) {
+            if (!pool)
+                pool = &HipaccThreadPool::getInstance(num_threads);
+
+            Task *task = new Task();
+            task->kernel = std::move(kernel);
+            task->name = name;
+            task->width = (int)is.width;
+            task->first_y = is.offset_y;
+            task->height = (int)is.height;
+            task->num_bands = hipaccNumBands(is, num_threads, *pool);
+            task->pending_bands = task->num_bands;
+            task->done = false;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                reap();
+                tasks.emplace_back(task);
+
+                std::vector<Task *> deps;
+                auto depend = [&] (Task *dep) {
+                    if (dep && !dep->done &&
+                        std::find(deps.begin(), deps.end(), dep) == deps.end())
+                        deps.push_back(dep);
+                };
+                for (auto mem : reads) {
+                    Access &acc = accesses[mem];
+                    depend(acc.writer);
+                    if (std::find(writes.begin(), writes.end(), mem) ==
+                        writes.end())
+                        acc.readers.push_back(task);
+                }
+                for (auto mem : writes) {
+                    Access &acc = accesses[mem];
+                    depend(acc.writer);
+                    for (auto reader : acc.readers)
+                        if (reader != task)
+                            depend(reader);
+                    acc.writer = task;
+                    acc.readers.clear();
+                }
+
+                for (auto dep : deps)
+                    dep->succs.push_back(task);
+                task->pending_deps = (int)deps.size();
+                if (task->pending_deps)
+                    return;
+            }
+            schedule(task);
+        }
+
+        // wait for all tasks writing mem, and reading it if write is set
+        void wait(const void *mem, bool write) {
+            waitFor([&] { return finished(mem, write); });
+        }
+
+        void waitAll() {
+            waitFor([&] {
+                for (auto &task : tasks)
+                    if (!task->done)
+                        return false;
+                return true;
+            });
+        }
+};
+
+
+// Launch kernel(args..., start_y, end_y) asynchronously. The arguments are
+// copied; reads lists the memory read by the kernel, writes its outputs, the
+// iteration space first. Each band of rows is traced separately under the
+// given name.
+template<typename F, typename... Args>
+void hipaccLaunchKernelAsync(HipaccAccessor &is, int num_threads,
+        std::initializer_list<const void *> reads,
+        std::initializer_list<const void *> writes,
+        const char *name, F kernel, Args... args) {
+    HipaccTaskGraph::getInstance().launch(is, num_threads, reads, writes, name,
+            std::bind(kernel, args..., std::placeholders::_1,
+                      std::placeholders::_2));
+}
+
+
+// Wait for all asynchronously launched kernels
+void hipaccSynchronizeKernels() {
+    HipaccTaskGraph::getInstance().waitAll();
+}
+
+#endif  // __HIPACC_CPU_THREADS_HPP__
+
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2014, Saarland University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_CPU_TUNING_HPP__
+#define __HIPACC_CPU_TUNING_HPP__
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+// Database of tuned kernel configurations. Entries are keyed by kernel name,
+// iteration space size, number of threads, and CPU model, and are stored one
+// per line in the file named by the environment variable HIPACC_TUNING_DB,
+// by default ~/.hipacc_tuning. Entries appended later take precedence.
+class HipaccTuningDB {
+    private:
+        std::map<std::string, int> entries;
+        std::string file, cpu;
+        std::mutex mutex;
+
+        HipaccTuningDB() {
+            const char *env = std::getenv("HIPACC_TUNING_DB");
+            const char *home = std::getenv("HOME");
+            if (env && *env)
+                file = env;
+            else if (home && *home)
+                file = std::string(home) + "/.hipacc_tuning";
+            else
+                file = ".hipacc_tuning";
+
+            cpu = "unknown";
+            std::ifstream cpuinfo("/proc/cpuinfo");
+            std::string line;
+            while (std::getline(cpuinfo, line)) {
+                if (line.compare(0, 10, "model name") == 0) {
+                    size_t pos = line.find(':');
+                    if (pos != std::string::npos)
+                        cpu = line.substr(line.find_first_not_of(" \t", pos+1));
+                    break;
+                }
+            }
+
+            std::ifstream is(file.c_str());
+            while (std::getline(is, line)) {
+                size_t pos = line.rfind('\t');
+                if (pos == std::string::npos)
+                    continue;
+                entries[line.substr(0, pos)] = std::atoi(line.c_str() + pos + 1);
+            }
+        }
+        HipaccTuningDB(HipaccTuningDB const &);
+        void operator=(HipaccTuningDB const &);
+
+    public:
+        static HipaccTuningDB &getInstance() {
+            static HipaccTuningDB instance;
+
+            return instance;
+        }
+
+        std::string key(const char *kernel, size_t width, size_t height,
+                        unsigned num_threads) const {
+            std::stringstream ss;
+            ss << kernel << "\t" << width << "x" << height << "\t"
+               << num_threads << "\t" << cpu;
+            return ss.str();
+        }
+
+        // tuned value for key, 0 if key is not tuned yet
+        int lookup(const std::string &key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            return it == entries.end() ? 0 : it->second;
+        }
+
+        void store(const std::string &key, int value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries[key] = value;
+            std::ofstream os(file.c_str(), std::ios::app);
+            if (os)
+                os << key << "\t" << value << "\n";
+            else
+                std::cerr << "<HIPACC:> Could not write tuning database "
+                          << file << std::endl;
+        }
+};
+
+#endif  // __HIPACC_CPU_TUNING_HPP__
+
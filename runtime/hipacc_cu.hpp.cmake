@@ -540,7 +540,11 @@ void hipaccLaunchKernel(const void *kernel, std::string kernel_name, dim3 grid,
     cudaEventDestroy(start);
     cudaEventDestroy(end);
 
-    if (print_timing) {
+    if (hipaccTraceEnabled()) {
+        int64_t end_time = hipacc_time_micro();
+        hipaccTraceKernel(kernel_name, grid.x*block.x, grid.y*block.y,
+                          end_time - (int64_t)(last_gpu_timing*1.0e3f), end_time);
+    } else if (print_timing) {
         std::cerr << "<HIPACC:> Kernel timing ("<< block.x*block.y << ": " << block.x << "x" << block.y << "): " << last_gpu_timing << "(ms)" << std::endl;
     }
 }
@@ -749,7 +753,11 @@ void hipaccLaunchKernel(CUfunction &kernel, std::string kernel_name, dim3 grid,
     cudaEventDestroy(start);
     cudaEventDestroy(end);
 
-    if (print_timing) {
+    if (hipaccTraceEnabled()) {
+        int64_t end_time = hipacc_time_micro();
+        hipaccTraceKernel(kernel_name, grid.x*block.x, grid.y*block.y,
+                          end_time - (int64_t)(last_gpu_timing*1.0e3f), end_time);
+    } else if (print_timing) {
         std::cerr << "<HIPACC:> Kernel timing (" << block.x*block.y << ": " << block.x << "x" << block.y << "): " << last_gpu_timing << "(ms)" << std::endl;
     }
 }
@@ -0,0 +1,223 @@
+//
+// Copyright (c) 2014, Saarland University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef __HIPACC_TRACE_HPP__
+#define __HIPACC_TRACE_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Trace of kernel executions. Tracing is enabled by setting the environment
+// variable HIPACC_TRACE to a file name; the trace is written to that file at
+// exit as Chrome trace JSON (chrome://tracing), or as CSV if the file name
+// ends in .csv. Kernel timings are then recorded instead of printed.
+
+enum hipaccTraceFormat {
+    ChromeTrace,
+    CSVTrace
+};
+
+typedef struct hipacc_trace_event {
+    const char *kernel;
+    int width, height;
+    int64_t start, end;
+    uint32_t thread;
+} hipacc_trace_event;
+
+
+// Ring of the most recent events of one thread. Only the owning thread
+// writes events; the events are read when the trace is written.
+class HipaccTraceBuffer {
+    public:
+        enum { size = 4096 };
+
+        hipacc_trace_event events[size];
+        std::atomic<uint64_t> head;
+        uint64_t tail;
+        uint32_t thread;
+
+        explicit HipaccTraceBuffer(uint32_t thread) :
+            head(0), tail(0), thread(thread) {}
+
+        void record(const hipacc_trace_event &event) {
+            uint64_t pos = head.load(std::memory_order_relaxed);
+            events[pos % size] = event;
+            head.store(pos + 1, std::memory_order_release);
+        }
+};
+
+
+class HipaccTrace {
+    private:
+        std::vector<std::unique_ptr<HipaccTraceBuffer>> buffers;
+        std::set<std::string> names;
+        std::mutex mutex;
+        std::string file;
+        bool enabled;
+
+        HipaccTrace() : enabled(false) {
+            const char *env = std::getenv("HIPACC_TRACE");
+            if (env && *env) {
+                file = env;
+                enabled = true;
+            }
+        }
+        HipaccTrace(HipaccTrace const &);
+        void operator=(HipaccTrace const &);
+
+        HipaccTraceBuffer &buffer() {
+            static thread_local HipaccTraceBuffer *buf = nullptr;
+            if (!buf) {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffers.emplace_back(new HipaccTraceBuffer(buffers.size()));
+                buf = buffers.back().get();
+            }
+            return *buf;
+        }
+
+    public:
+        ~HipaccTrace() {
+            if (!enabled)
+                return;
+            size_t len = file.size();
+            bool csv = len > 4 && file.compare(len - 4, 4, ".csv") == 0;
+            std::ofstream os(file.c_str());
+            if (os)
+                write(os, csv ? CSVTrace : ChromeTrace);
+            else
+                std::cerr << "<HIPACC:> Could not write trace to "
+                          << file << std::endl;
+        }
+
+        static HipaccTrace &getInstance() {
+            static HipaccTrace instance;
+
+            return instance;
+        }
+
+        bool is_enabled() const { return enabled; }
+
+        // name with the lifetime of the trace for kernel names not known at
+        // compile time
+        const char *intern(const std::string &name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return names.insert(name).first->c_str();
+        }
+
+        // kernel has to be a string literal
+        void record(const char *kernel, int width, int height, int64_t start,
+                    int64_t end) {
+            HipaccTraceBuffer &buf = buffer();
+            hipacc_trace_event event = { kernel, width, height, start, end,
+                                         buf.thread };
+            buf.record(event);
+        }
+
+        // write and drop the events recorded so far; events overwritten in
+        // the rings are lost. Must not be called while kernels are executed.
+        void write(std::ostream &os, hipaccTraceFormat format) {
+            std::vector<hipacc_trace_event> events;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto &buf : buffers) {
+                    uint64_t head = buf->head.load(std::memory_order_acquire);
+                    uint64_t first = std::max(buf->tail,
+                            head > HipaccTraceBuffer::size ?
+                            head - HipaccTraceBuffer::size : 0);
+                    for (uint64_t pos = first; pos < head; ++pos)
+                        events.push_back(buf->events[pos % HipaccTraceBuffer::size]);
+                    buf->tail = head;
+                }
+            }
+            std::sort(events.begin(), events.end(),
+                    [] (const hipacc_trace_event &a, const hipacc_trace_event &b) {
+                        return a.start < b.start;
+                    });
+
+            if (format == CSVTrace) {
+                os << "kernel,width,height,start_us,end_us,thread\n";
+                for (auto &e : events)
+                    os << e.kernel << "," << e.width << "," << e.height << ","
+                       << e.start << "," << e.end << "," << e.thread << "\n";
+            } else {
+                os << "{\"traceEvents\":[";
+                for (size_t i = 0; i < events.size(); ++i) {
+                    auto &e = events[i];
+                    os << (i ? ",\n" : "\n")
+                       << "{\"name\":\"" << e.kernel << "\",\"ph\":\"X\""
+                       << ",\"ts\":" << e.start << ",\"dur\":" << e.end - e.start
+                       << ",\"pid\":0,\"tid\":" << e.thread
+                       << ",\"args\":{\"width\":" << e.width
+                       << ",\"height\":" << e.height << "}}";
+                }
+                os << "\n]}\n";
+            }
+            os.flush();
+        }
+};
+
+
+bool hipaccTraceEnabled();
+void hipaccTraceKernel(const char *kernel, int width, int height,
+                       int64_t start, int64_t end);
+void hipaccTraceKernel(const std::string &kernel, int width, int height,
+                       int64_t start, int64_t end);
+void hipaccWriteTrace(std::ostream &os, hipaccTraceFormat format=ChromeTrace);
+
+#ifndef EXCLUDE_IMPL
+bool hipaccTraceEnabled() {
+    static const bool enabled = HipaccTrace::getInstance().is_enabled();
+    return enabled;
+}
+
+// record the execution of a kernel from start to end (in us)
+void hipaccTraceKernel(const char *kernel, int width, int height,
+                       int64_t start, int64_t end) {
+    HipaccTrace::getInstance().record(kernel, width, height, start, end);
+}
+
+void hipaccTraceKernel(const std::string &kernel, int width, int height,
+                       int64_t start, int64_t end) {
+    HipaccTrace &trace = HipaccTrace::getInstance();
+    trace.record(trace.intern(kernel), width, height, start, end);
+}
+
+void hipaccWriteTrace(std::ostream &os, hipaccTraceFormat format) {
+    HipaccTrace::getInstance().write(os, format);
+}
+#endif // EXCLUDE_IMPL
+
+#endif  // __HIPACC_TRACE_HPP__
+
@@ -25,12 +25,15 @@ CU_LINK         = $(CC_LINK) @NVCC_LINK@
 # Source-to-source compiler configuration
 # use local memory -> set HIPACC_LMEM to off|on
 # use texture memory -> set HIPACC_TEX to off|Linear1D|Linear2D|Array2D|Ldg
-# vectorize code (experimental, doesn't work) -> set HIPACC_VEC to off|on
+# vectorize code (experimental) -> set HIPACC_VEC to off|on; for cpu also sse4.2|avx2|avx512
 # pad images to a multiple of n bytes -> set HIPACC_PAD to n
 # map n output pixels to one thread -> set HIPACC_PPT to n
 # use specific configuration for kernels -> set HIPACC_CONFIG to nxm
 # generate code that explores configuration -> set HIPACC_EXPLORE to off|on
 # generate code that times kernel execution -> set HIPACC_TIMING to off|on
+# execute C++ kernels using n threads -> set HIPACC_CPU_THREADS to n|auto
+# launch C++ kernels asynchronously -> set HIPACC_CPU_ASYNC to off|on
+# split C++ kernels into cache blocks -> set HIPACC_CPU_TILE to auto|off|nxm
 HIPACC_LMEM?=off
 HIPACC_TEX?=off
 HIPACC_VEC?=off
@@ -57,6 +60,16 @@ endif
 ifdef HIPACC_VEC
     HIPACC_OPTS+= -vectorize $(HIPACC_VEC)
 endif
+# instruction set of the SIMD width selected for C++ kernels
+ifeq ($(HIPACC_VEC),sse4.2)
+    CC_VEC_FLAGS = -msse4.2
+endif
+ifneq ($(filter on avx2,$(HIPACC_VEC)),)
+    CC_VEC_FLAGS = -mavx2
+endif
+ifeq ($(HIPACC_VEC),avx512)
+    CC_VEC_FLAGS = -mavx512f -mavx512bw
+endif
 ifdef HIPACC_CONFIG
     HIPACC_OPTS+= -use-config $(HIPACC_CONFIG)
 endif
@@ -66,6 +79,26 @@ endif
 ifeq ($(HIPACC_TIMING),on)
     HIPACC_OPTS+= -time-kernels
 endif
+ifdef HIPACC_CPU_THREADS
+    HIPACC_OPTS+= -cpu-threads $(HIPACC_CPU_THREADS)
+endif
+ifdef HIPACC_CPU_ASYNC
+    HIPACC_OPTS+= -cpu-async $(HIPACC_CPU_ASYNC)
+endif
+ifdef HIPACC_CPU_TILE
+    HIPACC_OPTS+= -cpu-tile $(HIPACC_CPU_TILE)
+endif
+
+# Benchmark configuration
+# benchmark the C++ kernels of each test case in BENCH_CASES for all
+# combinations of image sizes BENCH_SIZES and mask sizes BENCH_MASKS, adding
+# BENCH_FLAGS (e.g. -DNO_SEP) to the defines; the median, minimum, and maximum
+# time of each kernel is appended to BENCH_RESULTS
+BENCH_CASES    ?= $(TEST_CASE)
+BENCH_SIZES    ?= 1024x1024 2048x2048 4096x4096
+BENCH_MASKS    ?= 3x3 5x5
+BENCH_FLAGS    ?=
+BENCH_RESULTS  ?= $(CURDIR)/bench.csv
 
 # set target GPU architecture to the compute capability encoded in target
 GPU_ARCH := $(shell echo $(HIPACC_TARGET) |cut -f2 -d-)
@@ -79,10 +112,30 @@ cpu:
 	@echo 'Executing Hipacc Compiler for C++:'
 	$(COMPILER) $(TEST_CASE)/main.cpp $(MYFLAGS) $(COMPILER_INC) -emit-cpu $(HIPACC_OPTS) -o main.cc
 	@echo 'Compiling C++ file using c++:'
-	$(CC_CC) -I$(HIPACC_DIR)/include $(COMMON_INC) $(MYFLAGS) $(OFLAGS) -o main_cpu main.cc $(CC_LINK)
+	$(CC_CC) -I$(HIPACC_DIR)/include $(COMMON_INC) $(MYFLAGS) $(OFLAGS) $(CC_VEC_FLAGS) -o main_cpu main.cc $(CC_LINK)
 	@echo 'Executing C++ binary'
 	./main_cpu
 
+bench:
+	rm -f $(BENCH_RESULTS)
+	@for case in $(BENCH_CASES); do \
+	    for size in $(BENCH_SIZES); do \
+	        for mask in $(BENCH_MASKS); do \
+	            $(MAKE) --no-print-directory bench-case HIPACC_TIMING=on TEST_CASE=$$case \
+	                MYFLAGS="-DWIDTH=$${size%x*} -DHEIGHT=$${size#*x} -DSIZE_X=$${mask%x*} -DSIZE_Y=$${mask#*x} $(BENCH_FLAGS)" \
+	                BENCH_LABEL="$$(basename $$case) $$size $$mask" || \
+	            echo "Benchmark of $$case ($$size, $$mask) failed"; \
+	        done; \
+	    done; \
+	done
+	@echo 'Benchmark results written to $(BENCH_RESULTS)'
+
+bench-case:
+	@echo 'Benchmarking $(BENCH_LABEL):'
+	$(COMPILER) $(TEST_CASE)/main.cpp $(MYFLAGS) $(COMPILER_INC) -emit-cpu $(HIPACC_OPTS) -o main.cc
+	$(CC_CC) -I$(HIPACC_DIR)/include $(COMMON_INC) $(MYFLAGS) $(OFLAGS) $(CC_VEC_FLAGS) -o main_cpu main.cc $(CC_LINK)
+	HIPACC_BENCH=$(BENCH_RESULTS) HIPACC_BENCH_LABEL="$(BENCH_LABEL)" ./main_cpu
+
 cuda:
 	@echo 'Executing Hipacc Compiler for CUDA:'
 	$(COMPILER) $(TEST_CASE)/main.cpp $(MYFLAGS) $(COMPILER_INC) -emit-cuda $(HIPACC_OPTS) -o main.cu
@@ -119,6 +172,6 @@ filterscript renderscript:
 	adb shell /data/local/tmp/main_$@
 
 clean:
-	rm -f main_* *.cu *.cc *.cubin *.cl *.isa *.rs *.fs
+	rm -f main_* bench.csv *.cu *.cc *.cubin *.cl *.isa *.rs *.fs
 	rm -rf build_*
 
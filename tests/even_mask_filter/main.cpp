@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// Copyright (c) 2010, ARM Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+// Masks of even width: the window of pixel x covers [x-size_x/2, x+size_x/2)
+#define SIZE_EVEN 4
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+
+// convolution reference
+void convolution(uchar *in, int *out, const int *filter, int size, int width, int height) {
+    int anchor = size >> 1;
+
+    for (int y=anchor; y<height-anchor; ++y) {
+        for (int x=anchor; x<width-anchor; ++x) {
+            int sum = 0;
+            for (int yf = -anchor; yf<size-anchor; ++yf) {
+                for (int xf = -anchor; xf<size-anchor; ++xf) {
+                    sum += filter[(yf+anchor)*size + xf+anchor] * in[(y + yf)*width + x + xf];
+                }
+            }
+            out[y*width + x] = sum;
+        }
+    }
+}
+
+
+// Kernel description in Hipacc
+class EvenMaskFilter : public Kernel<int> {
+    private:
+        Accessor<uchar> &in;
+        Mask<int> &mask;
+
+    public:
+        EvenMaskFilter(IterationSpace<int> &iter, Accessor<uchar> &in,
+                Mask<int> &mask) :
+            Kernel(iter),
+            in(in),
+            mask(mask)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::SUM, [&] () -> int {
+                    return mask() * in(mask);
+                    });
+        }
+};
+
+
+/*************************************************************************
+ * Main function                                                         *
+ *************************************************************************/
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int offset = SIZE_EVEN >> 1;
+
+    // separable binomial filter mask
+    const int filter_xy[SIZE_EVEN][SIZE_EVEN] = {
+        { 1, 3, 3, 1 },
+        { 3, 9, 9, 3 },
+        { 3, 9, 9, 3 },
+        { 1, 3, 3, 1 }
+    };
+    // box filter mask, summed by a sliding window
+    const int box_xy[SIZE_EVEN][SIZE_EVEN] = {
+        { 1, 1, 1, 1 },
+        { 1, 1, 1, 1 },
+        { 1, 1, 1, 1 },
+        { 1, 1, 1, 1 }
+    };
+
+    // host memory for image of width x height pixels
+    uchar *input = new uchar[width*height];
+    uchar *reference_in = new uchar[width*height];
+    int *reference_out = new int[width*height];
+    int *reference_box = new int[width*height];
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            uchar val = (uchar)((x*7 + y*13) % 256);
+            input[y*width + x] = val;
+            reference_in[y*width + x] = val;
+            reference_out[y*width + x] = 0;
+            reference_box[y*width + x] = 0;
+        }
+    }
+
+
+    // input and output image of width x height pixels
+    Image<uchar> in(width, height, input);
+    Image<int> out(width, height);
+    Image<int> out_box(width, height);
+
+    // define Masks for the filters
+    Mask<int> mask(filter_xy);
+    Mask<int> box(box_xy);
+
+    BoundaryCondition<uchar> bound(in, mask, Boundary::CLAMP);
+    Accessor<uchar> acc(bound);
+
+    IterationSpace<int> iter(out);
+    EvenMaskFilter filter(iter, acc, mask);
+
+    std::cerr << "Calculating Hipacc " << SIZE_EVEN << "x" << SIZE_EVEN << " filter ..." << std::endl;
+    filter.execute();
+    float timing = hipacc_last_kernel_timing();
+    std::cerr << "Hipacc (CLAMP): " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    IterationSpace<int> iter_box(out_box);
+    EvenMaskFilter box_filter(iter_box, acc, box);
+
+    std::cerr << "Calculating Hipacc " << SIZE_EVEN << "x" << SIZE_EVEN << " box filter ..." << std::endl;
+    box_filter.execute();
+    timing = hipacc_last_kernel_timing();
+    std::cerr << "Hipacc (CLAMP): " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    // get pointer to result data
+    int *output = out.data();
+    int *output_box = out_box.data();
+
+
+    std::cerr << "Calculating reference ..." << std::endl;
+    double start = time_ms();
+    convolution(reference_in, reference_out, (const int *)filter_xy, SIZE_EVEN, width, height);
+    convolution(reference_in, reference_box, (const int *)box_xy, SIZE_EVEN, width, height);
+    double end = time_ms();
+    float time = end - start;
+    std::cerr << "Reference: " << time << " ms, " << (width*height/time)/1000 << " Mpixel/s" << std::endl;
+
+
+    std::cerr << "Comparing results ..." << std::endl;
+    for (int y=offset; y<height-offset; ++y) {
+        for (int x=offset; x<width-offset; ++x) {
+            if (reference_out[y*width + x] != output[y*width + x]) {
+                std::cerr << "Test FAILED, at (" << x << "," << y << "): "
+                          << reference_out[y*width + x] << " vs. "
+                          << output[y*width + x] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            if (reference_box[y*width + x] != output_box[y*width + x]) {
+                std::cerr << "Test FAILED (box), at (" << x << "," << y << "): "
+                          << reference_box[y*width + x] << " vs. "
+                          << output_box[y*width + x] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    std::cerr << "Test PASSED" << std::endl;
+
+    // free memory
+    delete[] input;
+    delete[] reference_in;
+    delete[] reference_out;
+    delete[] reference_box;
+
+    return EXIT_SUCCESS;
+}
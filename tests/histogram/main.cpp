@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+#define NUM_BINS_8U 256
+#define NUM_BINS_32F 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+
+// reference
+void calc_histogram(uchar *in, uint *hist, int width, int height) {
+    for (int i=0; i<NUM_BINS_8U; ++i)
+        hist[i] = 0;
+    for (int y=0; y<height; ++y)
+        for (int x=0; x<width; ++x)
+            hist[in[y*width + x]]++;
+}
+
+void calc_histogram(float *in, uint *hist, int width, int height) {
+    for (int i=0; i<NUM_BINS_32F; ++i)
+        hist[i] = 0;
+    for (int y=0; y<height; ++y)
+        for (int x=0; x<width; ++x)
+            hist[(uint)(in[y*width + x] * (NUM_BINS_32F-1))]++;
+}
+
+
+// Kernel description in Hipacc
+class Histogram8U : public Kernel<uchar, uint> {
+    private:
+        Accessor<uchar> &in;
+
+    public:
+        Histogram8U(IterationSpace<uchar> &iter, Accessor<uchar> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        void binning(uint x, uint y, uchar pixel) {
+            bin(pixel) = 1;
+        }
+
+        uint reduce(uint left, uint right) const {
+            return left + right;
+        }
+};
+
+class Histogram32F : public Kernel<float, uint> {
+    private:
+        Accessor<float> &in;
+
+    public:
+        Histogram32F(IterationSpace<float> &iter, Accessor<float> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = in();
+        }
+
+        void binning(uint x, uint y, float pixel) {
+            bin((uint)(pixel * (NUM_BINS_32F-1))) = 1;
+        }
+
+        uint reduce(uint left, uint right) const {
+            return left + right;
+        }
+};
+
+
+/*************************************************************************
+ * Main function                                                         *
+ *************************************************************************/
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    float timing = 0;
+
+    // host memory for images of width x height pixels
+    uchar *input_8u = new uchar[width*height];
+    float *input_32f = new float[width*height];
+    uint *reference_8u = new uint[NUM_BINS_8U];
+    uint *reference_32f = new uint[NUM_BINS_32F];
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input_8u[y*width + x] = (uchar)((x*x + y) % 251);
+            input_32f[y*width + x] = (float)((x*7 + y*13) % 1000) / 999.0f;
+        }
+    }
+
+
+    // input and output images of width x height pixels
+    Image<uchar> in_8u(width, height, input_8u);
+    Image<uchar> out_8u(width, height);
+    Image<float> in_32f(width, height, input_32f);
+    Image<float> out_32f(width, height);
+
+    Accessor<uchar> acc_8u(in_8u);
+    Accessor<float> acc_32f(in_32f);
+
+    IterationSpace<uchar> iter_8u(out_8u);
+    IterationSpace<float> iter_32f(out_32f);
+
+    Histogram8U hist_8u(iter_8u, acc_8u);
+    Histogram32F hist_32f(iter_32f, acc_32f);
+
+    std::cerr << "Calculating Hipacc histograms ..." << std::endl;
+
+    hist_8u.execute();
+    double start = time_ms();
+    uint *output_8u = hist_8u.binned_data(NUM_BINS_8U);
+    timing = time_ms() - start;
+    std::cerr << "Hipacc 8U (" << NUM_BINS_8U << " bins): " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    hist_32f.execute();
+    start = time_ms();
+    uint *output_32f = hist_32f.binned_data(NUM_BINS_32F);
+    timing = time_ms() - start;
+    std::cerr << "Hipacc 32F (" << NUM_BINS_32F << " bins): " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+
+    std::cerr << std::endl << "Calculating reference ..." << std::endl;
+    calc_histogram(input_8u, reference_8u, width, height);
+    calc_histogram(input_32f, reference_32f, width, height);
+
+
+    std::cerr << "Comparing results ..." << std::endl;
+    for (int i=0; i<NUM_BINS_8U; ++i) {
+        if (reference_8u[i] != output_8u[i]) {
+            std::cerr << "Test FAILED, 8U bin " << i << ": "
+                      << reference_8u[i] << " vs. " << output_8u[i] << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i=0; i<NUM_BINS_32F; ++i) {
+        if (reference_32f[i] != output_32f[i]) {
+            std::cerr << "Test FAILED, 32F bin " << i << ": "
+                      << reference_32f[i] << " vs. " << output_32f[i] << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::cerr << "Test PASSED" << std::endl;
+
+    // free memory
+    delete[] input_8u;
+    delete[] input_32f;
+    delete[] reference_8u;
+    delete[] reference_32f;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+
+// reference
+void calc_integral_image(uchar *in, uint *out, int width, int height) {
+    for (int y=0; y<height; ++y) {
+        uint row_sum = 0;
+        for (int x=0; x<width; ++x) {
+            row_sum += in[y*width + x];
+            out[y*width + x] = row_sum + (y ? out[(y-1)*width + x] : 0);
+        }
+    }
+}
+
+
+// Kernel description in Hipacc
+class IntegralImage : public Kernel<uint> {
+    private:
+        Accessor<uchar> &in;
+
+    public:
+        IntegralImage(IterationSpace<uint> &iter, Accessor<uchar> &in) :
+            Kernel(iter),
+            in(in)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = (uint)in();
+        }
+
+        uint reduce(uint left, uint right) const {
+            return left + right;
+        }
+};
+
+
+/*************************************************************************
+ * Main function                                                         *
+ *************************************************************************/
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    float timing = 0;
+
+    // host memory for image of width x height pixels
+    uchar *input = new uchar[width*height];
+    uint *reference = new uint[width*height];
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input[y*width + x] = (uchar)((x*x + y) % 251);
+        }
+    }
+
+
+    // input and output image of width x height pixels
+    Image<uchar> in(width, height, input);
+    Image<uint> out(width, height);
+
+    Accessor<uchar> acc(in);
+
+    IterationSpace<uint> iter(out);
+    IntegralImage integral(iter, acc);
+
+    std::cerr << "Calculating Hipacc integral image ..." << std::endl;
+
+    integral.execute();
+    double start = time_ms();
+    integral.scan(Scan::IMAGE);
+    timing = time_ms() - start;
+    std::cerr << "Hipacc: " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    // get pointer to result data
+    uint *output = out.data();
+
+
+    std::cerr << std::endl << "Calculating reference ..." << std::endl;
+    calc_integral_image(input, reference, width, height);
+
+
+    std::cerr << "Comparing results ..." << std::endl;
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            if (reference[y*width + x] != output[y*width + x]) {
+                std::cerr << "Test FAILED, at (" << x << "," << y << "): "
+                          << reference[y*width + x] << " vs. "
+                          << output[y*width + x] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    std::cerr << "Test PASSED" << std::endl;
+
+    // free memory
+    delete[] input;
+    delete[] reference;
+
+    return EXIT_SUCCESS;
+}
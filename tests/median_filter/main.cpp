@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// Copyright (c) 2010, ARM Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define SIZE_X 5
+//#define SIZE_Y 5
+//#define WIDTH 4096
+//#define HEIGHT 4096
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+
+// Median filter reference
+void median_filter(uchar *in, uchar *out, int size_x, int size_y, int width, int height) {
+    int anchor_x = size_x >> 1;
+    int anchor_y = size_y >> 1;
+    int upper_x = width  - anchor_x;
+    int upper_y = height - anchor_y;
+    std::vector<uchar> values(size_x*size_y);
+
+    for (int y=anchor_y; y<upper_y; ++y) {
+        for (int x=anchor_x; x<upper_x; ++x) {
+            int i = 0;
+            for (int yf = -anchor_y; yf<size_y-anchor_y; ++yf) {
+                for (int xf = -anchor_x; xf<size_x-anchor_x; ++xf) {
+                    values[i++] = in[(y + yf)*width + x + xf];
+                }
+            }
+            std::nth_element(values.begin(), values.begin() + (i-1)/2, values.end());
+            out[y*width + x] = values[(i-1)/2];
+        }
+    }
+}
+
+
+// Kernel description in Hipacc
+class MedianFilter : public Kernel<uchar> {
+    private:
+        Accessor<uchar> &in;
+        Mask<uchar> &mask;
+
+    public:
+        MedianFilter(IterationSpace<uchar> &iter, Accessor<uchar> &in,
+                Mask<uchar> &mask) :
+            Kernel(iter),
+            in(in),
+            mask(mask)
+        { add_accessor(&in); }
+
+        void kernel() {
+            output() = convolve(mask, Reduce::MEDIAN, [&] () -> uchar {
+                    return in(mask);
+                    });
+        }
+};
+
+
+/*************************************************************************
+ * Main function                                                         *
+ *************************************************************************/
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    const int size_x = SIZE_X;
+    const int size_y = SIZE_Y;
+    const int offset_x = size_x >> 1;
+    const int offset_y = size_y >> 1;
+
+    // window of the median filter, the coefficients are not used
+    uchar coefficients[SIZE_Y][SIZE_X];
+    for (int y=0; y<size_y; ++y)
+        for (int x=0; x<size_x; ++x)
+            coefficients[y][x] = 1;
+
+    // host memory for image of width x height pixels
+    uchar *input = new uchar[width*height];
+    uchar *reference_in = new uchar[width*height];
+    uchar *reference_out = new uchar[width*height];
+
+    // initialize data: salt and pepper noise on a gradient
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            uchar val = (uchar)((x + y) % 256);
+            if ((x*7 + y*13) % 31 == 0) val = 0;
+            if ((x*11 + y*5) % 37 == 0) val = 255;
+            input[y*width + x] = val;
+            reference_in[y*width + x] = val;
+            reference_out[y*width + x] = 0;
+        }
+    }
+
+
+    // input and output image of width x height pixels
+    Image<uchar> in(width, height, input);
+    Image<uchar> out(width, height);
+
+    // define Mask for median filter
+    Mask<uchar> mask(coefficients);
+
+    BoundaryCondition<uchar> bound(in, mask, Boundary::CLAMP);
+    Accessor<uchar> acc(bound);
+
+    IterationSpace<uchar> iter(out);
+    MedianFilter filter(iter, acc, mask);
+
+    std::cerr << "Calculating Hipacc median filter ..." << std::endl;
+    filter.execute();
+    float timing = hipacc_last_kernel_timing();
+    std::cerr << "Hipacc (CLAMP): " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    // get pointer to result data
+    uchar *output = out.data();
+
+
+    std::cerr << "Calculating reference ..." << std::endl;
+    double start = time_ms();
+    median_filter(reference_in, reference_out, size_x, size_y, width, height);
+    double end = time_ms();
+    float time = end - start;
+    std::cerr << "Reference: " << time << " ms, " << (width*height/time)/1000 << " Mpixel/s" << std::endl;
+
+
+    std::cerr << "Comparing results ..." << std::endl;
+    for (int y=offset_y; y<height-offset_y; ++y) {
+        for (int x=offset_x; x<width-offset_x; ++x) {
+            if (reference_out[y*width + x] != output[y*width + x]) {
+                std::cerr << "Test FAILED, at (" << x << "," << y << "): "
+                          << (int)reference_out[y*width + x] << " vs. "
+                          << (int)output[y*width + x] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    std::cerr << "Test PASSED" << std::endl;
+
+    // free memory
+    delete[] input;
+    delete[] reference_in;
+    delete[] reference_out;
+
+    return EXIT_SUCCESS;
+}
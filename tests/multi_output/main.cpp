@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2012, University of Erlangen-Nuremberg
+// Copyright (c) 2012, Siemens AG
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/time.h>
+
+#include "hipacc.hpp"
+
+// variables set by Makefile
+//#define WIDTH 4096
+//#define HEIGHT 4096
+#define EPS 0.001f
+
+using namespace hipacc;
+using namespace hipacc::math;
+
+
+// get time in milliseconds
+double time_ms () {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+
+    return ((double)(tv.tv_sec) * 1e+3 + (double)(tv.tv_usec) * 1e-3);
+}
+
+
+// reference
+void calc_gradients(float *in, float *dx, float *dy, float *mag, int width,
+                    int height) {
+    auto pixel = [&] (int x, int y) {
+        x = std::min(std::max(x, 0), width-1);
+        y = std::min(std::max(y, 0), height-1);
+        return in[y*width + x];
+    };
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            float gx = pixel(x+1, y-1) + 2.0f*pixel(x+1, y) + pixel(x+1, y+1)
+                     - pixel(x-1, y-1) - 2.0f*pixel(x-1, y) - pixel(x-1, y+1);
+            float gy = pixel(x-1, y+1) + 2.0f*pixel(x, y+1) + pixel(x+1, y+1)
+                     - pixel(x-1, y-1) - 2.0f*pixel(x, y-1) - pixel(x+1, y-1);
+            dx[y*width + x] = gx;
+            dy[y*width + x] = gy;
+            mag[y*width + x] = std::sqrt(gx*gx + gy*gy);
+        }
+    }
+}
+
+
+// Kernel description in Hipacc: the Sobel derivatives and the gradient
+// magnitude are computed from the same neighborhood; dx is written to the
+// iteration space, dy and the magnitude through Accessors
+class Gradients : public Kernel<float> {
+    private:
+        Accessor<float> &in;
+        Accessor<float> &dy;
+        Accessor<float> &mag;
+
+    public:
+        Gradients(IterationSpace<float> &iter, Accessor<float> &in,
+                  Accessor<float> &dy, Accessor<float> &mag) :
+            Kernel(iter),
+            in(in),
+            dy(dy),
+            mag(mag)
+        { add_accessor(&in); add_accessor(&dy); add_accessor(&mag); }
+
+        void kernel() {
+            float tl = in(-1, -1), t = in(0, -1), tr = in(1, -1);
+            float l  = in(-1,  0),                r  = in(1,  0);
+            float bl = in(-1,  1), b = in(0,  1), br = in(1,  1);
+
+            float gx = tr + 2.0f*r + br - tl - 2.0f*l - bl;
+            float gy = bl + 2.0f*b + br - tl - 2.0f*t - tr;
+
+            output() = gx;
+            dy() = gy;
+            mag() = sqrtf(gx*gx + gy*gy);
+        }
+};
+
+
+/*************************************************************************
+ * Main function                                                         *
+ *************************************************************************/
+int main(int argc, const char **argv) {
+    const int width = WIDTH;
+    const int height = HEIGHT;
+    float timing = 0;
+
+    // host memory for image of width x height pixels
+    float *input = new float[width*height];
+    float *ref_dx = new float[width*height];
+    float *ref_dy = new float[width*height];
+    float *ref_mag = new float[width*height];
+
+    // initialize data
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            input[y*width + x] = (float)((x*x + 3*y) % 97) / 97.0f;
+        }
+    }
+
+
+    // input and output images of width x height pixels
+    Image<float> in(width, height, input);
+    Image<float> out_dx(width, height);
+    Image<float> out_dy(width, height);
+    Image<float> out_mag(width, height);
+
+    BoundaryCondition<float> bound(in, 3, 3, Boundary::CLAMP);
+    Accessor<float> acc(bound);
+    Accessor<float> acc_dy(out_dy);
+    Accessor<float> acc_mag(out_mag);
+
+    IterationSpace<float> iter(out_dx);
+    Gradients gradients(iter, acc, acc_dy, acc_mag);
+
+    std::cerr << "Calculating Hipacc gradients ..." << std::endl;
+
+    gradients.execute();
+    timing = hipacc_last_kernel_timing();
+    std::cerr << "Hipacc: " << timing << " ms, " << (width*height/timing)/1000 << " Mpixel/s" << std::endl;
+
+    // get pointer to result data
+    float *output_dx = out_dx.data();
+    float *output_dy = out_dy.data();
+    float *output_mag = out_mag.data();
+
+
+    std::cerr << std::endl << "Calculating reference ..." << std::endl;
+    double start = time_ms();
+    calc_gradients(input, ref_dx, ref_dy, ref_mag, width, height);
+    double end = time_ms();
+    std::cerr << "Reference: " << end-start << " ms, " << (width*height/(end-start))/1000 << " Mpixel/s" << std::endl;
+
+
+    std::cerr << "Comparing results ..." << std::endl;
+    float *refs[] = { ref_dx, ref_dy, ref_mag };
+    float *outputs[] = { output_dx, output_dy, output_mag };
+    for (int i=0; i<3; ++i) {
+        for (int y=0; y<height; ++y) {
+            for (int x=0; x<width; ++x) {
+                float ref = refs[i][y*width + x];
+                float val = outputs[i][y*width + x];
+                if (std::abs(ref - val) > EPS) {
+                    std::cerr << "Test FAILED, output " << i << " at (" << x
+                              << "," << y << "): " << ref << " vs. " << val
+                              << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+    std::cerr << "Test PASSED" << std::endl;
+
+    // free memory
+    delete[] input;
+    delete[] ref_dx;
+    delete[] ref_dy;
+    delete[] ref_mag;
+
+    return EXIT_SUCCESS;
+}
@@ -258,9 +258,10 @@ int main(int argc, const char **argv) {
 
     // filter coefficients
     #ifdef CONST_MASK
-    // only filter kernel sizes 3x3, 5x5, and 7x7 implemented
-    if (size_x != size_y || !(size_x == 3 || size_x == 5 || size_x == 7)) {
-        std::cerr << "Wrong filter kernel size. Currently supported values: 3x3, 5x5, and 7x7!" << std::endl;
+    // only filter kernel sizes 3x3, 5x5, 7x7, 9x9, 11x11, 13x13, and 15x15 implemented
+    if (size_x != size_y || !(size_x == 3 || size_x == 5 || size_x == 7 ||
+                              size_x == 9 || size_x == 11 || size_x == 13 || size_x == 15)) {
+        std::cerr << "Wrong filter kernel size. Currently supported values: 3x3, 5x5, 7x7, 9x9, 11x11, 13x13, and 15x15!" << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -275,6 +276,18 @@ int main(int argc, const char **argv) {
         #if SIZE_X == 7
         { 0.028995f, 0.103818f, 0.223173f, 0.288026f, 0.223173f, 0.103818f, 0.028995f }
         #endif
+        #if SIZE_X == 9
+        { 0.014839f, 0.049817f, 0.118323f, 0.198829f, 0.236384f, 0.198829f, 0.118323f, 0.049817f, 0.014839f }
+        #endif
+        #if SIZE_X == 11
+        { 0.008812f, 0.027144f, 0.065114f, 0.121649f, 0.176998f, 0.200565f, 0.176998f, 0.121649f, 0.065114f, 0.027144f, 0.008812f }
+        #endif
+        #if SIZE_X == 13
+        { 0.005799f, 0.016401f, 0.038399f, 0.074414f, 0.119371f, 0.158506f, 0.174219f, 0.158506f, 0.119371f, 0.074414f, 0.038399f, 0.016401f, 0.005799f }
+        #endif
+        #if SIZE_X == 15
+        { 0.004107f, 0.010743f, 0.024238f, 0.047162f, 0.079149f, 0.114567f, 0.143029f, 0.154010f, 0.143029f, 0.114567f, 0.079149f, 0.047162f, 0.024238f, 0.010743f, 0.004107f }
+        #endif
     };
     const float filter_y[SIZE_Y][1] = {
         #if SIZE_Y == 3
@@ -286,6 +299,18 @@ int main(int argc, const char **argv) {
         #if SIZE_Y == 7
         { 0.028995f }, { 0.103818f }, { 0.223173f }, { 0.288026f }, { 0.223173f }, { 0.103818f }, { 0.028995f }
         #endif
+        #if SIZE_Y == 9
+        { 0.014839f }, { 0.049817f }, { 0.118323f }, { 0.198829f }, { 0.236384f }, { 0.198829f }, { 0.118323f }, { 0.049817f }, { 0.014839f }
+        #endif
+        #if SIZE_Y == 11
+        { 0.008812f }, { 0.027144f }, { 0.065114f }, { 0.121649f }, { 0.176998f }, { 0.200565f }, { 0.176998f }, { 0.121649f }, { 0.065114f }, { 0.027144f }, { 0.008812f }
+        #endif
+        #if SIZE_Y == 13
+        { 0.005799f }, { 0.016401f }, { 0.038399f }, { 0.074414f }, { 0.119371f }, { 0.158506f }, { 0.174219f }, { 0.158506f }, { 0.119371f }, { 0.074414f }, { 0.038399f }, { 0.016401f }, { 0.005799f }
+        #endif
+        #if SIZE_Y == 15
+        { 0.004107f }, { 0.010743f }, { 0.024238f }, { 0.047162f }, { 0.079149f }, { 0.114567f }, { 0.143029f }, { 0.154010f }, { 0.143029f }, { 0.114567f }, { 0.079149f }, { 0.047162f }, { 0.024238f }, { 0.010743f }, { 0.004107f }
+        #endif
     };
     const float filter_xy[SIZE_Y][SIZE_X] = {
         #if SIZE_X == 3
@@ -309,6 +334,62 @@ int main(int argc, const char **argv) {
         { 0.003010, 0.010778, 0.023169, 0.029902, 0.023169, 0.010778, 0.003010 },
         { 0.000841, 0.003010, 0.006471, 0.008351, 0.006471, 0.003010, 0.000841 }
         #endif
+        #if SIZE_X == 9
+        { 0.000220f, 0.000739f, 0.001756f, 0.002951f, 0.003508f, 0.002951f, 0.001756f, 0.000739f, 0.000220f },
+        { 0.000739f, 0.002482f, 0.005895f, 0.009905f, 0.011776f, 0.009905f, 0.005895f, 0.002482f, 0.000739f },
+        { 0.001756f, 0.005895f, 0.014000f, 0.023526f, 0.027969f, 0.023526f, 0.014000f, 0.005895f, 0.001756f },
+        { 0.002951f, 0.009905f, 0.023526f, 0.039533f, 0.047000f, 0.039533f, 0.023526f, 0.009905f, 0.002951f },
+        { 0.003508f, 0.011776f, 0.027969f, 0.047000f, 0.055877f, 0.047000f, 0.027969f, 0.011776f, 0.003508f },
+        { 0.002951f, 0.009905f, 0.023526f, 0.039533f, 0.047000f, 0.039533f, 0.023526f, 0.009905f, 0.002951f },
+        { 0.001756f, 0.005895f, 0.014000f, 0.023526f, 0.027969f, 0.023526f, 0.014000f, 0.005895f, 0.001756f },
+        { 0.000739f, 0.002482f, 0.005895f, 0.009905f, 0.011776f, 0.009905f, 0.005895f, 0.002482f, 0.000739f },
+        { 0.000220f, 0.000739f, 0.001756f, 0.002951f, 0.003508f, 0.002951f, 0.001756f, 0.000739f, 0.000220f }
+        #endif
+        #if SIZE_X == 11
+        { 0.000078f, 0.000239f, 0.000574f, 0.001072f, 0.001560f, 0.001767f, 0.001560f, 0.001072f, 0.000574f, 0.000239f, 0.000078f },
+        { 0.000239f, 0.000737f, 0.001767f, 0.003302f, 0.004804f, 0.005444f, 0.004804f, 0.003302f, 0.001767f, 0.000737f, 0.000239f },
+        { 0.000574f, 0.001767f, 0.004240f, 0.007921f, 0.011525f, 0.013060f, 0.011525f, 0.007921f, 0.004240f, 0.001767f, 0.000574f },
+        { 0.001072f, 0.003302f, 0.007921f, 0.014798f, 0.021532f, 0.024399f, 0.021532f, 0.014798f, 0.007921f, 0.003302f, 0.001072f },
+        { 0.001560f, 0.004804f, 0.011525f, 0.021532f, 0.031328f, 0.035500f, 0.031328f, 0.021532f, 0.011525f, 0.004804f, 0.001560f },
+        { 0.001767f, 0.005444f, 0.013060f, 0.024399f, 0.035500f, 0.040226f, 0.035500f, 0.024399f, 0.013060f, 0.005444f, 0.001767f },
+        { 0.001560f, 0.004804f, 0.011525f, 0.021532f, 0.031328f, 0.035500f, 0.031328f, 0.021532f, 0.011525f, 0.004804f, 0.001560f },
+        { 0.001072f, 0.003302f, 0.007921f, 0.014798f, 0.021532f, 0.024399f, 0.021532f, 0.014798f, 0.007921f, 0.003302f, 0.001072f },
+        { 0.000574f, 0.001767f, 0.004240f, 0.007921f, 0.011525f, 0.013060f, 0.011525f, 0.007921f, 0.004240f, 0.001767f, 0.000574f },
+        { 0.000239f, 0.000737f, 0.001767f, 0.003302f, 0.004804f, 0.005444f, 0.004804f, 0.003302f, 0.001767f, 0.000737f, 0.000239f },
+        { 0.000078f, 0.000239f, 0.000574f, 0.001072f, 0.001560f, 0.001767f, 0.001560f, 0.001072f, 0.000574f, 0.000239f, 0.000078f }
+        #endif
+        #if SIZE_X == 13
+        { 0.000034f, 0.000095f, 0.000223f, 0.000432f, 0.000692f, 0.000919f, 0.001010f, 0.000919f, 0.000692f, 0.000432f, 0.000223f, 0.000095f, 0.000034f },
+        { 0.000095f, 0.000269f, 0.000630f, 0.001220f, 0.001958f, 0.002600f, 0.002857f, 0.002600f, 0.001958f, 0.001220f, 0.000630f, 0.000269f, 0.000095f },
+        { 0.000223f, 0.000630f, 0.001474f, 0.002857f, 0.004584f, 0.006086f, 0.006690f, 0.006086f, 0.004584f, 0.002857f, 0.001474f, 0.000630f, 0.000223f },
+        { 0.000432f, 0.001220f, 0.002857f, 0.005538f, 0.008883f, 0.011795f, 0.012964f, 0.011795f, 0.008883f, 0.005538f, 0.002857f, 0.001220f, 0.000432f },
+        { 0.000692f, 0.001958f, 0.004584f, 0.008883f, 0.014250f, 0.018921f, 0.020797f, 0.018921f, 0.014250f, 0.008883f, 0.004584f, 0.001958f, 0.000692f },
+        { 0.000919f, 0.002600f, 0.006086f, 0.011795f, 0.018921f, 0.025124f, 0.027615f, 0.025124f, 0.018921f, 0.011795f, 0.006086f, 0.002600f, 0.000919f },
+        { 0.001010f, 0.002857f, 0.006690f, 0.012964f, 0.020797f, 0.027615f, 0.030352f, 0.027615f, 0.020797f, 0.012964f, 0.006690f, 0.002857f, 0.001010f },
+        { 0.000919f, 0.002600f, 0.006086f, 0.011795f, 0.018921f, 0.025124f, 0.027615f, 0.025124f, 0.018921f, 0.011795f, 0.006086f, 0.002600f, 0.000919f },
+        { 0.000692f, 0.001958f, 0.004584f, 0.008883f, 0.014250f, 0.018921f, 0.020797f, 0.018921f, 0.014250f, 0.008883f, 0.004584f, 0.001958f, 0.000692f },
+        { 0.000432f, 0.001220f, 0.002857f, 0.005538f, 0.008883f, 0.011795f, 0.012964f, 0.011795f, 0.008883f, 0.005538f, 0.002857f, 0.001220f, 0.000432f },
+        { 0.000223f, 0.000630f, 0.001474f, 0.002857f, 0.004584f, 0.006086f, 0.006690f, 0.006086f, 0.004584f, 0.002857f, 0.001474f, 0.000630f, 0.000223f },
+        { 0.000095f, 0.000269f, 0.000630f, 0.001220f, 0.001958f, 0.002600f, 0.002857f, 0.002600f, 0.001958f, 0.001220f, 0.000630f, 0.000269f, 0.000095f },
+        { 0.000034f, 0.000095f, 0.000223f, 0.000432f, 0.000692f, 0.000919f, 0.001010f, 0.000919f, 0.000692f, 0.000432f, 0.000223f, 0.000095f, 0.000034f }
+        #endif
+        #if SIZE_X == 15
+        { 0.000017f, 0.000044f, 0.000100f, 0.000194f, 0.000325f, 0.000471f, 0.000587f, 0.000633f, 0.000587f, 0.000471f, 0.000325f, 0.000194f, 0.000100f, 0.000044f, 0.000017f },
+        { 0.000044f, 0.000115f, 0.000260f, 0.000507f, 0.000850f, 0.001231f, 0.001537f, 0.001655f, 0.001537f, 0.001231f, 0.000850f, 0.000507f, 0.000260f, 0.000115f, 0.000044f },
+        { 0.000100f, 0.000260f, 0.000587f, 0.001143f, 0.001918f, 0.002777f, 0.003467f, 0.003733f, 0.003467f, 0.002777f, 0.001918f, 0.001143f, 0.000587f, 0.000260f, 0.000100f },
+        { 0.000194f, 0.000507f, 0.001143f, 0.002224f, 0.003733f, 0.005403f, 0.006746f, 0.007263f, 0.006746f, 0.005403f, 0.003733f, 0.002224f, 0.001143f, 0.000507f, 0.000194f },
+        { 0.000325f, 0.000850f, 0.001918f, 0.003733f, 0.006265f, 0.009068f, 0.011321f, 0.012190f, 0.011321f, 0.009068f, 0.006265f, 0.003733f, 0.001918f, 0.000850f, 0.000325f },
+        { 0.000471f, 0.001231f, 0.002777f, 0.005403f, 0.009068f, 0.013126f, 0.016386f, 0.017644f, 0.016386f, 0.013126f, 0.009068f, 0.005403f, 0.002777f, 0.001231f, 0.000471f },
+        { 0.000587f, 0.001537f, 0.003467f, 0.006746f, 0.011321f, 0.016386f, 0.020457f, 0.022028f, 0.020457f, 0.016386f, 0.011321f, 0.006746f, 0.003467f, 0.001537f, 0.000587f },
+        { 0.000633f, 0.001655f, 0.003733f, 0.007263f, 0.012190f, 0.017644f, 0.022028f, 0.023719f, 0.022028f, 0.017644f, 0.012190f, 0.007263f, 0.003733f, 0.001655f, 0.000633f },
+        { 0.000587f, 0.001537f, 0.003467f, 0.006746f, 0.011321f, 0.016386f, 0.020457f, 0.022028f, 0.020457f, 0.016386f, 0.011321f, 0.006746f, 0.003467f, 0.001537f, 0.000587f },
+        { 0.000471f, 0.001231f, 0.002777f, 0.005403f, 0.009068f, 0.013126f, 0.016386f, 0.017644f, 0.016386f, 0.013126f, 0.009068f, 0.005403f, 0.002777f, 0.001231f, 0.000471f },
+        { 0.000325f, 0.000850f, 0.001918f, 0.003733f, 0.006265f, 0.009068f, 0.011321f, 0.012190f, 0.011321f, 0.009068f, 0.006265f, 0.003733f, 0.001918f, 0.000850f, 0.000325f },
+        { 0.000194f, 0.000507f, 0.001143f, 0.002224f, 0.003733f, 0.005403f, 0.006746f, 0.007263f, 0.006746f, 0.005403f, 0.003733f, 0.002224f, 0.001143f, 0.000507f, 0.000194f },
+        { 0.000100f, 0.000260f, 0.000587f, 0.001143f, 0.001918f, 0.002777f, 0.003467f, 0.003733f, 0.003467f, 0.002777f, 0.001918f, 0.001143f, 0.000587f, 0.000260f, 0.000100f },
+        { 0.000044f, 0.000115f, 0.000260f, 0.000507f, 0.000850f, 0.001231f, 0.001537f, 0.001655f, 0.001537f, 0.001231f, 0.000850f, 0.000507f, 0.000260f, 0.000115f, 0.000044f },
+        { 0.000017f, 0.000044f, 0.000100f, 0.000194f, 0.000325f, 0.000471f, 0.000587f, 0.000633f, 0.000587f, 0.000471f, 0.000325f, 0.000194f, 0.000100f, 0.000044f, 0.000017f }
+        #endif
     };
     #else
     float filter_x[1][SIZE_X];